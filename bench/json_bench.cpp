@@ -0,0 +1,565 @@
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstdlib>
+#include <cstdio>
+#include <atomic>
+#include <map>
+#include <new>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
+
+#include "wrapidjson/document.h"
+#include "wrapidjson/ndjson.h"
+
+using namespace wrapidjson;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// allocation counter ( allocs/op counter of every benchmark )
+///  - glibc : malloc / calloc / realloc are interposed, so rapidjson allocator chunks
+///            ( CrtAllocator, MemoryPoolAllocator ) are counted as well as operator new
+///  - other : only global operator new is counted, DOM chunks are not visible
+/////////////////////////////////////////////////////////////////////////////////////////////
+static std::atomic<size_t> g_allocs(0);
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void __libc_free(void* p);
+
+void* malloc(size_t size) noexcept {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) noexcept {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+void free(void* p) noexcept {
+    __libc_free(p);
+}
+} // extern "C"
+#else
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+#endif
+
+namespace {
+
+class AllocCounter {
+public:
+    explicit AllocCounter(benchmark::State& state) : state_(state), start_(g_allocs.load()) {}
+    ~AllocCounter() {
+        state_.counters["allocs/op"] = benchmark::Counter(
+            static_cast<double>(g_allocs.load() - start_), benchmark::Counter::kAvgIterations);
+    }
+private:
+    benchmark::State&   state_;
+    size_t              start_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// corpus : twitter.json, canada.json, citm_catalog.json from nativejson-benchmark
+/// directory is WRAPIDJSON_BENCH_DATA environment variable or bench/data
+/////////////////////////////////////////////////////////////////////////////////////////////
+std::string corpus_path(const std::string& name) {
+    const char* dir = std::getenv("WRAPIDJSON_BENCH_DATA");
+    return std::string(dir != nullptr ? dir : WRAPIDJSON_BENCH_DATA_DIR) + "/" + name;
+}
+
+const std::string& corpus(const std::string& name) {
+    static std::map<std::string, std::string> cache;
+    auto it = cache.find(name);
+    if (it == cache.end()) {
+        std::ifstream ifs(corpus_path(name), std::ios::binary);
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+        it = cache.emplace(name, ss.str()).first;
+    }
+    return it->second;
+}
+
+bool load_corpus(benchmark::State& state, const std::string& name, std::string& json) {
+    json = corpus(name);
+    if (json.empty()) {
+        state.SkipWithError(("missing corpus " + corpus_path(name)).c_str());
+        return false;
+    }
+    return true;
+}
+
+/// {"k0":0,"k1":1,...}
+std::string wide_object(size_t members) {
+    std::string json = "{";
+    for (size_t i = 0; i < members; ++i) {
+        json += (i == 0 ? "\"k" : ",\"k") + std::to_string(i) + "\":" + std::to_string(i);
+    }
+    return json + "}";
+}
+
+/// [0.5,1.5,...]
+std::string double_array(size_t n) {
+    std::string json = "[";
+    for (size_t i = 0; i < n; ++i) {
+        json += (i == 0 ? "" : ",") + std::to_string(i) + ".5";
+    }
+    return json + "]";
+}
+
+/// {"id":0,"name":"user0","tags":["a","b"]}\n ...
+std::string ndjson_lines(size_t n) {
+    std::string data;
+    for (size_t i = 0; i < n; ++i) {
+        data += "{\"id\":" + std::to_string(i) + ",\"name\":\"user" + std::to_string(i) +
+            "\",\"tags\":[\"a\",\"b\"],\"score\":" + std::to_string(i) + ".25}\n";
+    }
+    return data;
+}
+
+} // namespace
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// load
+/////////////////////////////////////////////////////////////////////////////////////////////
+static void BM_rapidjson_parse(benchmark::State& state, const std::string& name) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        rapidjson::Document doc;
+        doc.Parse<0>(json.data(), json.size());
+        benchmark::DoNotOptimize(doc.HasParseError());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * json.size()));
+}
+
+static void BM_load_from_buffer(benchmark::State& state, const std::string& name) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        Document doc;
+        benchmark::DoNotOptimize(doc.load_from_buffer(string_view(json)));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * json.size()));
+}
+
+static void BM_load_from_buffer_insitu(benchmark::State& state, const std::string& name) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::string copy = json;
+        state.ResumeTiming();
+        Document doc;
+        benchmark::DoNotOptimize(doc.load_from_buffer_insitu(std::move(copy)));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * json.size()));
+}
+
+static void BM_load_reuse_arena(benchmark::State& state, const std::string& name) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    Arena arena;
+    Document doc(arena);
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        doc.reset();
+        benchmark::DoNotOptimize(doc.load_from_buffer(string_view(json)));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * json.size()));
+}
+
+static void BM_load_from_file(benchmark::State& state, const std::string& name) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    std::string path = corpus_path(name);
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        Document doc;
+        benchmark::DoNotOptimize(doc.load_from_file(path));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * json.size()));
+}
+
+static void BM_load_from_mmap(benchmark::State& state, const std::string& name) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    std::string path = corpus_path(name);
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        Document doc;
+        benchmark::DoNotOptimize(doc.load_from_mmap(path));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * json.size()));
+}
+
+static void BM_load_from_stream(benchmark::State& state, const std::string& name) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::istringstream is(json);
+        state.ResumeTiming();
+        Document doc;
+        benchmark::DoNotOptimize(doc.load_from_stream(is));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * json.size()));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// save
+/////////////////////////////////////////////////////////////////////////////////////////////
+static void BM_rapidjson_write(benchmark::State& state, const std::string& name) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    rapidjson::Document doc;
+    doc.Parse<0>(json.data(), json.size());
+    rapidjson::StringBuffer buffer;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        buffer.Clear();
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        doc.Accept(writer);
+        benchmark::DoNotOptimize(buffer.GetString());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * buffer.GetSize()));
+}
+
+static void BM_save_to_buffer(benchmark::State& state, const std::string& name, bool pretty) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    Document doc;
+    doc.load_from_buffer(string_view(json));
+    std::string buffer;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(doc.save_to_buffer(buffer, pretty));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * buffer.size()));
+}
+
+static void BM_save_to_stream(benchmark::State& state, const std::string& name, bool pretty) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    Document doc;
+    doc.load_from_buffer(string_view(json));
+    size_t bytes = 0;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        std::ostringstream os;
+        benchmark::DoNotOptimize(doc.save_to_stream(os, pretty));
+        bytes += static_cast<size_t>(os.tellp());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+static void BM_save_to_file(benchmark::State& state, const std::string& name, bool pretty) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    Document doc;
+    doc.load_from_buffer(string_view(json));
+    std::string path = "json_bench_save.json";
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(doc.save_to_file(path, pretty));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * json.size()));
+    std::remove(path.c_str());
+}
+
+static void BM_value_to_string(benchmark::State& state, const std::string& name) {
+    std::string json;
+    if (not load_corpus(state, name, json)) {
+        return;
+    }
+    Document doc;
+    doc.load_from_buffer(string_view(json));
+    ValueRef root = doc;
+    size_t bytes = 0;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        std::string out = root.to_string();
+        bytes += out.size();
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// member lookup on wide object ( range(0) members, last member is looked up )
+/////////////////////////////////////////////////////////////////////////////////////////////
+static void BM_rapidjson_find_member(benchmark::State& state) {
+    size_t members = static_cast<size_t>(state.range(0));
+    rapidjson::Document doc;
+    std::string json = wide_object(members);
+    doc.Parse<0>(json.c_str());
+    std::string name = "k" + std::to_string(members - 1);
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        auto it = doc.FindMember(rapidjson::StringRef(name.c_str(), name.size()));
+        benchmark::DoNotOptimize(it->value.GetInt());
+    }
+}
+
+static void BM_object_operator(benchmark::State& state) {
+    size_t members = static_cast<size_t>(state.range(0));
+    Document doc(wide_object(members));
+    ObjectRef object = doc.get_object();
+    std::string name = "k" + std::to_string(members - 1);
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(object[name].as<int>());
+    }
+}
+
+static void BM_object_get_value(benchmark::State& state) {
+    size_t members = static_cast<size_t>(state.range(0));
+    Document doc(wide_object(members));
+    ObjectRef object = doc.get_object();
+    std::string name = "k" + std::to_string(members - 1);
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(object.get_value<int>(name));
+    }
+}
+
+static void BM_object_get_value_key(benchmark::State& state) {
+    size_t members = static_cast<size_t>(state.range(0));
+    Document doc(wide_object(members));
+    ObjectRef object = doc.get_object();
+    std::string name = "k" + std::to_string(members - 1);
+    Key key(name);
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(object.get_value<int>(key));
+    }
+}
+
+static void BM_object_get_value_index(benchmark::State& state) {
+    size_t members = static_cast<size_t>(state.range(0));
+    Document doc(wide_object(members));
+    ObjectRef object = doc.get_object();
+    object.enable_index();
+    std::string name = "k" + std::to_string(members - 1);
+    Key key(name);
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(object.get_value<int>(key));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// array extraction ( range(0) doubles )
+/////////////////////////////////////////////////////////////////////////////////////////////
+static void BM_rapidjson_array_loop(benchmark::State& state) {
+    rapidjson::Document doc;
+    std::string json = double_array(static_cast<size_t>(state.range(0)));
+    doc.Parse<0>(json.c_str());
+    std::vector<double> out;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        out.clear();
+        for (auto& v : doc.GetArray()) {
+            out.push_back(v.GetDouble());
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_array_get_vector(benchmark::State& state) {
+    Document doc(double_array(static_cast<size_t>(state.range(0))));
+    ArrayRef array = doc.get_array();
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        auto values = array.get_vector<double>();
+        benchmark::DoNotOptimize(values->data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_array_get_vector_reuse(benchmark::State& state) {
+    Document doc(double_array(static_cast<size_t>(state.range(0))));
+    ArrayRef array = doc.get_array();
+    std::vector<double> out;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(array.get_vector(out));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_array_as_vector(benchmark::State& state) {
+    Document doc(double_array(static_cast<size_t>(state.range(0))));
+    ArrayRef array = doc.get_array();
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        auto values = array.as_vector<double>();
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// set_container ( range(0) elements )
+/////////////////////////////////////////////////////////////////////////////////////////////
+static void BM_set_container_vector(benchmark::State& state) {
+    std::vector<int> values(static_cast<size_t>(state.range(0)), 7);
+    Arena arena;
+    Document doc(arena);
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        doc.reset();
+        doc.set_container(values);
+        benchmark::DoNotOptimize(doc.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_set_container_map(benchmark::State& state) {
+    std::map<std::string, int> values;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        values["key" + std::to_string(i)] = static_cast<int>(i);
+    }
+    Arena arena;
+    Document doc(arena);
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        doc.reset();
+        doc.set_container(values);
+        benchmark::DoNotOptimize(doc.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// NDJSON ( range(0) lines )
+/////////////////////////////////////////////////////////////////////////////////////////////
+static void BM_ndjson_reader(benchmark::State& state) {
+    std::string data = ndjson_lines(static_cast<size_t>(state.range(0)));
+    NdjsonReader reader;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        int64_t sum = 0;
+        reader.read_from_buffer(data, [&sum](Document& doc) {
+            sum += doc["id"].as<int64_t>();
+            return true;
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+
+static void BM_parallel_ndjson_reader(benchmark::State& state) {
+    std::string data = ndjson_lines(static_cast<size_t>(state.range(0)));
+    ParallelNdjsonReader reader(0, true, 1 << 16);
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        std::atomic<int64_t> sum(0);
+        reader.read_from_buffer(data, [&sum](Document& doc) {
+            sum += doc["id"].as<int64_t>();
+            return true;
+        });
+        benchmark::DoNotOptimize(sum.load());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+
+#define WRAPIDJSON_CORPUS_BENCHMARK(func)                               \
+    BENCHMARK_CAPTURE(func, twitter, std::string("twitter.json"));      \
+    BENCHMARK_CAPTURE(func, canada, std::string("canada.json"));        \
+    BENCHMARK_CAPTURE(func, citm_catalog, std::string("citm_catalog.json"))
+
+#define WRAPIDJSON_SAVE_BENCHMARK(func)                                         \
+    BENCHMARK_CAPTURE(func, twitter_compact, std::string("twitter.json"), false);  \
+    BENCHMARK_CAPTURE(func, twitter_pretty, std::string("twitter.json"), true);    \
+    BENCHMARK_CAPTURE(func, canada_compact, std::string("canada.json"), false);    \
+    BENCHMARK_CAPTURE(func, canada_pretty, std::string("canada.json"), true);      \
+    BENCHMARK_CAPTURE(func, citm_catalog_compact, std::string("citm_catalog.json"), false); \
+    BENCHMARK_CAPTURE(func, citm_catalog_pretty, std::string("citm_catalog.json"), true)
+
+WRAPIDJSON_CORPUS_BENCHMARK(BM_rapidjson_parse);
+WRAPIDJSON_CORPUS_BENCHMARK(BM_load_from_buffer);
+WRAPIDJSON_CORPUS_BENCHMARK(BM_load_from_buffer_insitu);
+WRAPIDJSON_CORPUS_BENCHMARK(BM_load_reuse_arena);
+WRAPIDJSON_CORPUS_BENCHMARK(BM_load_from_file);
+WRAPIDJSON_CORPUS_BENCHMARK(BM_load_from_mmap);
+WRAPIDJSON_CORPUS_BENCHMARK(BM_load_from_stream);
+
+WRAPIDJSON_CORPUS_BENCHMARK(BM_rapidjson_write);
+WRAPIDJSON_SAVE_BENCHMARK(BM_save_to_buffer);
+WRAPIDJSON_SAVE_BENCHMARK(BM_save_to_stream);
+WRAPIDJSON_SAVE_BENCHMARK(BM_save_to_file);
+WRAPIDJSON_CORPUS_BENCHMARK(BM_value_to_string);
+
+BENCHMARK(BM_rapidjson_find_member)->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK(BM_object_operator)->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK(BM_object_get_value)->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK(BM_object_get_value_key)->Arg(8)->Arg(64)->Arg(1024);
+BENCHMARK(BM_object_get_value_index)->Arg(8)->Arg(64)->Arg(1024);
+
+BENCHMARK(BM_rapidjson_array_loop)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_array_get_vector)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_array_get_vector_reuse)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_array_as_vector)->Arg(1000)->Arg(100000);
+
+BENCHMARK(BM_set_container_vector)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_set_container_map)->Arg(100)->Arg(10000);
+
+BENCHMARK(BM_ndjson_reader)->Arg(10000);
+BENCHMARK(BM_parallel_ndjson_reader)->Arg(10000)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -1,4 +1,13 @@
 #include <string>
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
 #include <list>
 #include <map>
 #include <set>
@@ -8,6 +17,15 @@
 #include <gtest/gtest.h>
 
 #include "wrapidjson/document.h"
+#include "wrapidjson/reader.h"
+#include "wrapidjson/ndjson.h"
+#include "wrapidjson/binding.h"
+#include "wrapidjson/serializer.h"
+#include "wrapidjson/path.h"
+#include "wrapidjson/lazy.h"
+#include "wrapidjson/push.h"
+#include "wrapidjson/snapshot.h"
+#include "wrapidjson/stats.h"
 
 using namespace wrapidjson;
 
@@ -86,6 +104,46 @@ TEST(wrapidjsonTest, to_string_test)
     EXPECT_EQ(value["string"].to_string(), R"("string test")");
     EXPECT_EQ(value["array"].to_string(), R"(["array","test"])");
     EXPECT_EQ(value["object"].to_string(), R"({"obj":1,"test":2})");
+    EXPECT_EQ(value["object"].get_object().to_string(), R"({"obj":1,"test":2})");
+    EXPECT_EQ(value["array"].get_array().to_string(true), "[\n    \"array\",\n    \"test\"\n]");
+
+    // reusable output buffer
+    rapidjson::StringBuffer buffer;
+    EXPECT_TRUE(value["int"].write_to(buffer));
+    EXPECT_STREQ(buffer.GetString(), "32");
+    buffer.Clear();
+    EXPECT_TRUE(value["array"].write_to(buffer));
+    EXPECT_STREQ(buffer.GetString(), R"(["array","test"])");
+
+    std::string str = "old";
+    EXPECT_TRUE(value["object"].write_to(str));
+    EXPECT_EQ(str, R"({"obj":1,"test":2})");
+
+    std::ostringstream oss;
+    EXPECT_TRUE(value["string"].write_to(oss));
+    EXPECT_EQ(oss.str(), R"("string test")");
+}
+
+TEST(wrapidjsonTest, save_to_buffer_reuse)
+{
+    Document doc(R"({"code":200,"items":[1,2,3]})");
+
+    std::string out;
+    out.reserve(1024);
+    const char* data = out.data();
+    EXPECT_TRUE(doc.save_to_buffer(out));
+    EXPECT_EQ(out, R"({"code":200,"items":[1,2,3]})");
+    EXPECT_EQ(out.data(), data);    // written in place
+
+    out = "HTTP/1.1 200 OK\r\n\r\n";
+    EXPECT_TRUE(doc.append_to_buffer(out));
+    EXPECT_EQ(out, "HTTP/1.1 200 OK\r\n\r\n" R"({"code":200,"items":[1,2,3]})");
+    EXPECT_TRUE(doc["items"].append_to(out));
+    EXPECT_EQ(out, "HTTP/1.1 200 OK\r\n\r\n" R"({"code":200,"items":[1,2,3]}[1,2,3])");
+
+    rapidjson::StringBuffer buffer;
+    EXPECT_TRUE(doc.save_to_buffer(buffer));
+    EXPECT_STREQ(buffer.GetString(), R"({"code":200,"items":[1,2,3]})");
 }
 
 TEST(wrapidjsonTest, document_copy)
@@ -136,6 +194,131 @@ TEST(wrapidjsonTest, document_copy)
     }
 }
 
+TEST(wrapidjsonTest, document_move)
+{
+    // Document move : no copy, moved-from is empty and reusable
+    Document source(R"({"items":[1,2,3],"name":"move"})");
+    const rapidjson::Value* items = &source["items"].get_rvalue();
+
+    Document moved(std::move(source));
+    EXPECT_TRUE(source.is_null());
+    EXPECT_EQ(&moved["items"].get_rvalue(), items);
+    EXPECT_EQ(moved["name"].as<std::string>(), "move");
+
+    EXPECT_TRUE(source.load_from_buffer("[1]"));
+    EXPECT_EQ(source.size(), 1u);
+    EXPECT_EQ(moved.size(), 2u);
+
+    Document assigned;
+    assigned = std::move(moved);
+    EXPECT_TRUE(moved.is_null());
+    EXPECT_EQ(&assigned["items"].get_rvalue(), items);
+
+    Document copy = assigned.clone();
+    EXPECT_NE(&copy["items"].get_rvalue(), items);
+    EXPECT_EQ(copy.to_string(), assigned.to_string());
+
+    // move_from / swap in one Document : O(1)
+    Document doc(R"({"a":{"x":1},"b":[1,2]})");
+    const rapidjson::Value* x = &doc["a"]["x"].get_rvalue();
+    ValueRef c = doc["c"];      // insert first, inserting may move sibling members
+    c.move_from(doc["a"]);
+    EXPECT_TRUE(doc["a"].is_null());
+    EXPECT_EQ(&doc["c"]["x"].get_rvalue(), x);
+
+    doc["b"].swap(doc["c"]);
+    EXPECT_EQ(doc["b"]["x"].as<int>(), 1);
+    EXPECT_EQ(doc["c"].size(), 2u);
+
+    // between Documents : deep copy
+    Document other(R"({"y":2})");
+    EXPECT_FALSE(doc.shares_allocator(other));
+    doc["a"].move_from(other);
+    EXPECT_TRUE(other.is_null());
+    EXPECT_EQ(doc["a"]["y"].as<int>(), 2);
+
+    // graft : takes over source's storage, no copy
+    Document part(R"({"id":7,"tags":["a","b"]})");
+    const rapidjson::Value* tags = &part["tags"].get_rvalue();
+    ValueRef user = doc["user"];
+    doc.graft(user, std::move(part));
+    EXPECT_TRUE(part.is_null());
+    EXPECT_EQ(&doc["user"]["tags"].get_rvalue(), tags);
+    doc["user"]["tags"].get_array().push_back("c");
+    EXPECT_EQ(doc["user"]["tags"].size(), 3u);
+    EXPECT_EQ(doc["user"].to_string(), R"({"id":7,"tags":["a","b","c"]})");
+
+    // graft on same Arena : strings of in-situ source must outlive source
+    Arena arena(1024);
+    Document target(arena);
+    target["name"] = "target";
+    {
+        Document insitu(arena);
+        EXPECT_TRUE(insitu.load_from_buffer_insitu(std::string(R"({"tags":["insitu","strings"]})")));
+        EXPECT_TRUE(target.shares_allocator(insitu));
+        target.graft(target["part"], std::move(insitu));
+        EXPECT_TRUE(insitu.is_null());
+    }
+    EXPECT_EQ(target["part"]["tags"].get_array()[0].as<std::string>(), "insitu");
+    EXPECT_EQ(target.to_string(), R"({"name":"target","part":{"tags":["insitu","strings"]}})");
+
+    // grafted storage is kept by failed load, released by next successful load
+    Document host(R"({"a":1})");
+    host.graft(host["donor"], Document(R"({"big":"donor"})"));
+    EXPECT_EQ(host.graft_count(), 1u);
+    EXPECT_FALSE(host.load_from_buffer("{"));
+    EXPECT_EQ(host.graft_count(), 1u);
+    EXPECT_EQ(host["donor"]["big"].as<std::string>(), "donor");
+    EXPECT_TRUE(host.load_from_buffer(R"({"b":2})"));
+    EXPECT_EQ(host.graft_count(), 0u);
+
+    // graft into root replaces whole Document
+    Document root(R"([1,2])");
+    doc.graft(doc, std::move(root));
+    EXPECT_TRUE(doc.is_array());
+    EXPECT_EQ(doc.size(), 2u);
+}
+
+TEST(wrapidjsonTest, stats_test)
+{
+    class ParseCounter : public StatsHook {
+    public:
+        void on_parse(const ParseEvent& event) override { bytes += event.bytes; }
+        size_t bytes = 0;
+    } hook;
+    set_stats_hook(&hook);
+    reset_stats();
+
+    Document doc;
+    EXPECT_TRUE(doc.load_from_buffer("{\"a\":1}"));
+    EXPECT_TRUE(doc.has("a"));
+    EXPECT_FALSE(doc.has("b"));
+    Document copy(doc["a"]);
+    EXPECT_EQ(doc.to_string(), "{\"a\":1}");
+    Stats stats = get_stats();
+    set_stats_hook(nullptr);
+
+#if WRAPIDJSON_ENABLE_STATS
+    EXPECT_EQ(stats.parse_count, 1u);
+    EXPECT_EQ(stats.parse_errors, 0u);
+    EXPECT_EQ(stats.parse_bytes, 7u);
+    EXPECT_GT(stats.allocator_size, 0u);
+    EXPECT_EQ(stats.lookup_count, 3u);
+    EXPECT_EQ(stats.lookup_miss, 1u);
+    EXPECT_EQ(stats.deep_copy_count, 1u);
+    EXPECT_EQ(stats.serialize_count, 1u);
+    EXPECT_EQ(stats.serialize_bytes, 7u);
+    EXPECT_EQ(hook.bytes, 7u);
+#else
+    EXPECT_EQ(stats.parse_count, 0u);
+    EXPECT_EQ(stats.lookup_count, 0u);
+    EXPECT_EQ(hook.bytes, 0u);
+#endif
+    std::string metrics = format_prometheus(stats);
+    EXPECT_NE(metrics.find("# TYPE wrapidjson_parse_total counter\n"), std::string::npos);
+    EXPECT_NE(metrics.find("wrapidjson_lookup_miss_total "), std::string::npos);
+}
+
 TEST(wrapidjsonTest, json_format_error)
 {
     Document doc;
@@ -538,6 +721,78 @@ TEST(wrapidjsonTest, array_test)
     EXPECT_EQ(b_.size(), 18u);
 }
 
+TEST(wrapidjsonTest, bulk_array)
+{
+    Document doc;
+    std::vector<double> values(10000);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = i * 0.5;
+    }
+    ArrayRef array = doc["values"];
+    array.append(values.data(), values.size());
+    EXPECT_EQ(array.size(), values.size());
+
+    std::vector<double> out;
+    EXPECT_TRUE(array.get_vector(out));
+    EXPECT_EQ(values, out);
+    EXPECT_EQ(values, *array.get_vector<double>());
+
+    std::vector<double> buffer(values.size());
+    EXPECT_FALSE(array.copy_to(buffer.data(), buffer.size() - 1));
+    EXPECT_TRUE(array.copy_to(buffer.data(), buffer.size()));
+    EXPECT_EQ(values, buffer);
+
+    // range check like ValueRef::get
+    ArrayRef small = doc["small"];
+    std::vector<int> ints = {1, 300, -2};
+    small.append(ints.data(), ints.size());
+    std::vector<int8_t> bytes = {7};
+    EXPECT_FALSE(small.get_vector(bytes));
+    EXPECT_EQ(bytes.size(), 1u);
+    std::vector<unsigned> uints;
+    EXPECT_FALSE(small.get_vector(uints));
+    EXPECT_TRUE(small.get_vector(ints));
+    EXPECT_EQ(std::vector<int>({1, 300, -2}), ints);
+    EXPECT_EQ(std::vector<int>({1, 300, -2}), small.as_vector<int>());
+
+    const bool flags[] = {true, false, true};
+    ArrayRef bools = doc["flags"];
+    bools.append(flags, 3);
+    EXPECT_EQ(std::vector<bool>({true, false, true}), *bools.get_vector<bool>());
+    EXPECT_FALSE(bools.get_vector<int>());
+}
+
+TEST(wrapidjsonTest, get_columns)
+{
+    Document doc;
+    EXPECT_TRUE(doc.load_from_buffer(
+        "[{\"ts\":1,\"v\":0.5,\"id\":\"a\"},"
+        " {\"ts\":2,\"v\":1.5,\"id\":\"b\"},"
+        " {\"id\":\"c\",\"v\":2.5,\"ts\":3}]"));
+    ArrayRef rows = doc.get_array();
+
+    std::vector<int64_t> ts;
+    std::vector<double> v;
+    std::vector<std::string> id;
+    EXPECT_TRUE(rows.get_columns(column("ts", ts), column("v", v), column("id", id)));
+    EXPECT_EQ(std::vector<int64_t>({1, 2, 3}), ts);
+    EXPECT_EQ(std::vector<double>({0.5, 1.5, 2.5}), v);
+    EXPECT_EQ(std::vector<std::string>({"a", "b", "c"}), id);
+
+    // optional column appends default for missing member
+    std::vector<int> extra = {9};
+    EXPECT_TRUE(rows.get_columns(column("ts", ts), column("extra", extra, false)));
+    EXPECT_EQ(std::vector<int>({0, 0, 0}), extra);
+
+    // required column missing or wrong type fails and clears
+    EXPECT_FALSE(rows.get_columns(column("ts", ts), column("extra", extra)));
+    EXPECT_TRUE(ts.empty());
+    EXPECT_FALSE(rows.get_columns(column("id", ts)));
+
+    rows.push_back(1);
+    EXPECT_FALSE(rows.get_columns(column("ts", ts)));
+}
+
 TEST(wrapidjsonTest, set_container)
 {
     Document root;
@@ -611,6 +866,285 @@ TEST(wrapidjsonTest, set_container)
     EXPECT_EQ(root.size(), 25u);
 }
 
+TEST(wrapidjsonTest, nested_container)
+{
+    Document root;
+
+    std::vector<std::vector<double>> a = {{0.5, 1.5}, {}, {2.5}};
+    std::map<std::string, std::vector<int>> b = { {"x", {1, 2}}, {"y", {}} };
+    std::vector<std::map<std::string, std::string>> c = { {{"k", "v"}}, {} };
+    std::map<std::string, std::map<std::string, std::list<unsigned long>>> d = { {"p", {{"q", {7, 8}}}} };
+
+    root["a"] = a;
+    root["b"].set_container(b);
+    root["c"].set_container(c, false);  // strings not copied at any level
+    root["d"].set_container(d, false);
+
+    std::string exp = R"({"a":[[0.5,1.5],[],[2.5]],"b":{"x":[1,2],"y":[]},"c":[{"k":"v"},{}],"d":{"p":{"q":[7,8]}}})";
+    EXPECT_EQ(exp, root.to_string());
+
+    // str_copy=false keeps references into the source strings
+    EXPECT_EQ(c[0]["k"].data(), root["c"].get_array()[0]["k"].as<string_view>().data());
+    MemberRef p = *root["d"].get_object().begin();
+    MemberRef x = *root["b"].get_object().begin();
+    EXPECT_EQ(d.begin()->first.data(), p.name.as<string_view>().data());
+    EXPECT_NE(b.begin()->first.data(), x.name.as<string_view>().data());
+
+    ArrayRef rows = root["rows"];
+    rows = std::vector<std::vector<int64_t>>{{1, 2, 3}, {4}};
+    EXPECT_EQ(rows.size(), 2u);
+    EXPECT_EQ(rows[1].as<int64_t>(), 0);
+    EXPECT_EQ(*rows[0].get_array().get_vector<int64_t>(), (std::vector<int64_t>{1, 2, 3}));
+
+    // char is not a bulk element, still a number like rapidjson::Value(int)
+    root["chars"].set_container(std::vector<char>{'a', 'b'});
+    root["wide"] = std::map<std::string, std::vector<char16_t>>{ {"w", {u'z'}} };
+    EXPECT_EQ(root["chars"].to_string(), "[97,98]");
+    EXPECT_EQ(root["wide"].to_string(), R"({"w":[122]})");
+}
+
+TEST(wrapidjsonTest, snapshot_test)
+{
+    Document doc;
+    ASSERT_TRUE(doc.load_from_buffer(R"({"server":{"port":80,"hosts":["a","b"]},"ratio":[0.5,1.5]})"));
+
+    SharedSnapshot config(std::move(doc));
+    auto first = config.load();
+    EXPECT_EQ((*first)["server"]["port"].as<int>(), 80);
+    EXPECT_EQ((*first)["server"]["hosts"][1].as<std::string>(), "b");
+    EXPECT_TRUE((*first)["missing"]["deeper"].is_null());     // lookups never insert
+    EXPECT_FALSE(first->has("missing"));
+    EXPECT_FALSE(first->find("missing"));
+    EXPECT_EQ(first->to_string(), R"({"server":{"port":80,"hosts":["a","b"]},"ratio":[0.5,1.5]})");
+    EXPECT_THROW((*first)["ratio"][2], std::runtime_error);
+    std::vector<double> ratio;
+    EXPECT_TRUE((*first)["ratio"].get_vector(ratio));
+    EXPECT_EQ(ratio, (std::vector<double>{0.5, 1.5}));
+
+    std::weak_ptr<const Snapshot> old = first;
+    first.reset();
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> bad(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&config, &stop, &bad]() {
+            SharedSnapshot::Reader reader(config);
+            while (not stop) {
+                int port = reader->root()["server"]["port"].as<int>();
+                if (port != 80 and port != 8080) {
+                    ++bad;
+                }
+            }
+            reader.release();
+        });
+    }
+
+    Document next;
+    ASSERT_TRUE(next.load_from_buffer(R"({"server":{"port":8080}})"));
+    config.store(std::move(next));
+    EXPECT_EQ(config.version(), 1u);
+    EXPECT_EQ((*config.load())["server"]["port"].as<int>(), 8080);
+
+    stop = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+    EXPECT_EQ(bad, 0);
+    EXPECT_TRUE(old.expired());     // no reader holds the first Snapshot
+
+    Document copy = config.load()->clone();
+    copy["server"]["port"] = 9090;
+    EXPECT_EQ((*config.load())["server"]["port"].as<int>(), 8080);
+}
+
+TEST(wrapidjsonTest, push_parser)
+{
+    std::string stream = R"({"id":1,"s":"a\"}]"} [1,[2,{"k":"v"}]] "text" 42)";
+    std::vector<std::string> expect = {R"({"id":1,"s":"a\"}]"})", R"([1,[2,{"k":"v"}]])", R"("text")", "42"};
+
+    for (size_t chunk : {1, 3, 7, 64}) {
+        Document doc;
+        PushParser parser(doc);
+        std::vector<std::string> values;
+        for (size_t i = 0; i < stream.size(); i += chunk) {
+            size_t n = std::min(chunk, stream.size() - i);
+            size_t used = 0;
+            while (used < n and parser.feed(stream.data() + i + used, n - used) == PushStatus::COMPLETE) {
+                used += parser.consumed();
+                values.push_back(doc.to_string());
+                parser.reset();
+            }
+            EXPECT_FALSE(parser.failed());
+        }
+        EXPECT_EQ(parser.status(), PushStatus::NEED_MORE);     // number needs delimiter
+        EXPECT_EQ(parser.finish(), PushStatus::COMPLETE);
+        values.push_back(doc.to_string());
+        EXPECT_EQ(expect, values);
+    }
+
+    Document doc;
+    PushParser parser(doc, 16);
+    EXPECT_EQ(parser.feed(R"({"a":[1,2)"), PushStatus::NEED_MORE);
+    EXPECT_EQ(parser.feed(R"(,3}])"), PushStatus::FAILED);      // mismatched bracket
+    EXPECT_EQ(parser.feed("{}"), PushStatus::FAILED);         // until reset
+    EXPECT_NE(parser.error_code(), rapidjson::kParseErrorNone);
+
+    parser.reset();
+    EXPECT_EQ(parser.feed(R"({"a":"0123456789abcdef)"), PushStatus::FAILED);   // over max_size
+    EXPECT_EQ(parser.error_code(), rapidjson::kParseErrorTermination);
+
+    parser.reset();
+    EXPECT_EQ(parser.feed(R"({"a")"), PushStatus::NEED_MORE);
+    EXPECT_EQ(parser.finish(), PushStatus::FAILED);
+}
+
+TEST(wrapidjsonTest, msgpack_test)
+{
+    Document small(R"({"a":1})");
+    std::string packed;
+    EXPECT_TRUE(small.save_to_msgpack(packed));
+    EXPECT_EQ(packed, std::string("\x81\xa1" "a" "\x01"));
+
+    std::string json = R"({"id":123456789012,"neg":-40000,"small":-3,"u8":200,"pi":3.141592653589793,)"
+        R"("half":0.5,"ok":true,"no":false,"nil":null,"name":"wrapidjson",)"
+        R"("long":"0123456789012345678901234567890123456789","list":[1,[2,[3]],{}],"empty":[]})";
+    Document doc(json);
+    ASSERT_TRUE(doc.save_to_msgpack(packed));
+    EXPECT_LT(packed.size(), json.size());
+
+    Document decoded;
+    ASSERT_TRUE(decoded.load_from_msgpack(packed));
+    EXPECT_EQ(json, decoded.to_string());
+    EXPECT_TRUE(decoded["id"].get_rvalue().IsInt64());
+    EXPECT_TRUE(decoded["half"].is_double());
+
+    std::string framed = "header";
+    EXPECT_TRUE(doc.append_to_msgpack(framed));
+    EXPECT_EQ(framed.substr(6), packed);
+
+    // errors keep Document Null and report offset
+    EXPECT_FALSE(decoded.load_from_msgpack(string_view(packed.data(), packed.size() - 1)));
+    EXPECT_TRUE(decoded.is_null());
+    EXPECT_FALSE(decoded.load_from_msgpack(std::string("\x81\x01\x01")));   // key is not string
+    EXPECT_EQ(decoded.get_load_error(), "Error offset[1]: Missing a name for object member.");
+    EXPECT_FALSE(decoded.load_from_msgpack(std::string("\xdd\xff\xff\xff\xff")));   // count over input
+    EXPECT_FALSE(decoded.load_from_msgpack(string_view()));
+    EXPECT_FALSE(decoded.load_from_buffer("[1,"));
+    EXPECT_TRUE(decoded.load_from_msgpack(std::string("\x92\xc3\xc0")));
+    EXPECT_EQ(decoded.to_string(), "[true,null]");
+}
+
+TEST(wrapidjsonTest, error_test)
+{
+    Document doc(R"({"id":7,"name":"json","list":[1,2]})");
+
+    auto list = doc.try_at("list");
+    ASSERT_TRUE(list);
+    EXPECT_EQ(list->try_at(1)->as<int>(), 2);
+    EXPECT_EQ(list->try_at(2).error(), ErrorCode::OUT_OF_RANGE);
+    EXPECT_EQ(doc.try_at(1).error(), ErrorCode::NOT_ARRAY);
+    EXPECT_EQ(doc.try_at("missing").error(), ErrorCode::NO_MEMBER);
+    EXPECT_EQ(doc["id"].try_at("x").error(), ErrorCode::NOT_OBJECT);
+    EXPECT_FALSE(doc.has("missing"));      // nothing is inserted
+
+    EXPECT_EQ(*doc.try_get<int>("id"), 7);
+    EXPECT_EQ(doc.try_get<std::string>("name").value(), "json");
+    EXPECT_EQ(doc.try_get<int>("name").error(), ErrorCode::TYPE_MISMATCH);
+    EXPECT_EQ(doc.try_get<int>("nope"_key).error(), ErrorCode::NO_MEMBER);
+    EXPECT_EQ(doc.try_get<int>("nope").value_or(-1), -1);
+    EXPECT_THROW(doc.try_get<int>("nope").value(), std::runtime_error);
+    EXPECT_STREQ(error_string(ErrorCode::NO_MEMBER), "member not found");
+
+    std::string bad = "{\n  \"a\": x}";
+    EXPECT_FALSE(doc.load_from_buffer(bad));
+    const LoadError& error = doc.load_error();
+    EXPECT_TRUE(error);
+    EXPECT_EQ(error.code(), rapidjson::kParseErrorValueInvalid);
+    EXPECT_EQ(error.offset(), 9u);
+    EXPECT_EQ(error.line(bad), 2u);
+    EXPECT_EQ(error.column(bad), 8u);
+    EXPECT_EQ(doc.get_load_error(), "Error offset[9]: Invalid value.");
+    char buffer[16];
+    EXPECT_EQ(error.write(buffer, sizeof(buffer)), 31);    // truncated like snprintf
+    EXPECT_STREQ(buffer, "Error offset[9]");
+
+    EXPECT_TRUE(doc.load_from_buffer("[]"));
+    EXPECT_FALSE(doc.load_error());
+    EXPECT_EQ(doc.try_at(0).error(), ErrorCode::OUT_OF_RANGE);
+
+    // missing file is an error of this load, not the previous result
+    EXPECT_FALSE(doc.load_from_file("wrapidjson_not_exist.json"));
+    EXPECT_TRUE(doc.load_error());
+    EXPECT_EQ(doc.load_error().io_error(), ENOENT);
+    EXPECT_EQ(doc.load_error().code(), rapidjson::kParseErrorNone);
+    EXPECT_EQ(doc.get_load_error(), "Error io[" + std::to_string(ENOENT) + "]: " + std::strerror(ENOENT));
+    EXPECT_FALSE(doc.load_from_buffer(""));    // empty document is a parse error, not io
+    EXPECT_EQ(doc.load_error().io_error(), 0);
+    EXPECT_EQ(doc.load_error().code(), rapidjson::kParseErrorDocumentEmpty);
+
+    ReaderHandler handler;
+    Reader reader;
+    EXPECT_TRUE(reader.read_from_buffer("[1]", handler));
+    EXPECT_FALSE(reader.read_from_file("wrapidjson_not_exist.json", handler));
+    EXPECT_EQ(reader.io_error(), ENOENT);
+    EXPECT_FALSE(reader.stopped());
+    EXPECT_EQ(reader.get_read_error(), "Error io[" + std::to_string(ENOENT) + "]: " + std::strerror(ENOENT));
+    EXPECT_TRUE(reader.read_from_buffer("[1]", handler));
+    EXPECT_EQ(reader.io_error(), 0);
+}
+
+TEST(wrapidjsonTest, save_options)
+{
+    const std::string path = "wrapidjson_save_test.json";
+    Document doc;
+    auto values = doc["values"].set_array();
+    for (int i = 0; i < 2000; ++i) {
+        values.push_back(i);        // larger than one direct io block
+    }
+    const std::string expected = doc.to_string();
+
+    for (bool direct : {false, true}) {
+        for (bool atomic : {false, true}) {
+            SaveOptions options;
+            options.buffer_size = 100;      // rounded up to DIRECT_ALIGNMENT for direct
+            options.atomic = atomic;
+            options.direct = direct;
+            options.sync = SyncPolicy::DATASYNC;
+            EXPECT_TRUE(doc.save_to_file(path, options));
+
+            Document loaded;
+            EXPECT_TRUE(loaded.load_from_file(path));
+            EXPECT_EQ(loaded.to_string(), expected);
+        }
+    }
+
+    SaveOptions options;
+    options.pretty = true;
+    options.atomic = true;
+    EXPECT_TRUE(doc["values"].write_to_file(path, options));
+    Document loaded;
+    EXPECT_TRUE(loaded.load_from_file(path));
+    EXPECT_EQ(loaded.size(), 2000u);
+
+    // failed atomic save leaves no temp file and never touches path
+    EXPECT_FALSE(doc.save_to_file("wrapidjson_not_exist/save.json", options));
+
+    // async save from the published Snapshot, later stores do not change the file
+    SharedSnapshot shared(doc.clone());
+    auto saved = save_to_file_async(shared, path);
+    shared.store(Document(R"({"values":[]})"));
+    EXPECT_TRUE(saved.get());
+    EXPECT_TRUE(loaded.load_from_file(path));
+    EXPECT_EQ(loaded.to_string(), expected);
+
+    EXPECT_TRUE(save_to_file_async(Document(R"({"id":1})"), path).get());
+    EXPECT_TRUE(loaded.load_from_file(path));
+    EXPECT_EQ(loaded["id"].as<int>(), 1);
+    EXPECT_FALSE(save_to_file_async(SharedSnapshot::pointer(), path).get());
+    std::remove(path.c_str());
+}
+
 TEST(wrapidjsonTest, find_test)
 {
     Document doc;
@@ -643,3 +1177,723 @@ TEST(wrapidjsonTest, find_test)
     EXPECT_TRUE(root.find_all(std::vector<std::string>{"TEST2"}));
     EXPECT_FALSE(root.find_all(std::vector<std::string>{"TEST2", "TEST3"}));
 }
+
+TEST(wrapidjsonTest, key_test)
+{
+    static constexpr Key ID("id");
+    static_assert(ID.size() == 2, "constexpr key");
+    static_assert(ID.hash() == "id"_key.hash(), "constexpr hash");
+    EXPECT_EQ(Key(std::string("id")).hash(), ID.hash());
+
+    Document doc(R"({"id":7,"name":"wrapidjson","score":1.5})");
+    EXPECT_EQ(doc[ID].as<int>(), 7);
+    EXPECT_TRUE(doc.has("name"_key));
+    EXPECT_FALSE(doc.has("nam"_key));
+    EXPECT_TRUE(doc.find("score"_key));
+    EXPECT_FALSE(doc.find("scores"_key));
+
+    auto obj = doc.get_object();
+    EXPECT_EQ(obj.count(ID), 1);
+    EXPECT_EQ(*obj.get_value<std::string>("name"_key), "wrapidjson");
+    EXPECT_EQ(*obj.get_value<double>("score"_key), 1.5);
+    EXPECT_EQ(obj.get_value<int>("missing"_key, 3), 3);
+
+    // insert copies the name
+    std::string name = "added";
+    obj[Key(name)] = 1;
+    name = "xxxxx";
+    EXPECT_EQ(doc["added"].as<int>(), 1);
+}
+
+TEST(wrapidjsonTest, object_index)
+{
+    Document doc;
+    for (int i = 0; i < 100; ++i) {
+        doc["id" + std::to_string(i)] = i;
+    }
+
+    auto obj = doc.get_object();
+    obj.enable_index(8);
+    EXPECT_TRUE(obj.indexed());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(obj["id" + std::to_string(i)].as<int>(), i);
+    }
+    EXPECT_FALSE(obj.has("id100"));
+    EXPECT_TRUE(obj.has(Key("id42")));
+    EXPECT_EQ(obj.size(), 100u);
+
+    // insert updates index, order is unchanged
+    obj["id100"] = 100;
+    obj.insert("extra", 1);
+    EXPECT_EQ(*obj.get_value<int>("id100"), 100);
+    EXPECT_EQ(*obj.get_value<int>("extra"), 1);
+    EXPECT_EQ((obj.end() - 1)->name.as<std::string>(), "extra");
+
+    // erase invalidates index
+    obj.erase("id0");
+    EXPECT_FALSE(obj.has("id0"));
+    EXPECT_EQ(obj["id99"].as<int>(), 99);
+    EXPECT_EQ(obj.begin()->name.as<std::string>(), "id1");
+
+    // modified through other handle
+    doc["other"] = 7;
+    EXPECT_EQ(*obj.get_value<int>("other"), 7);
+
+    // duplicate name resolves to first member like FindMember
+    obj.insert("id1", 1000);
+    EXPECT_EQ(obj["id1"].as<int>(), 1);
+
+    EXPECT_TRUE(obj.find_all(std::vector<std::string>{"id1", "id50", "extra"}));
+    EXPECT_FALSE(obj.find_all(std::vector<std::string>{"id1", "id500"}));
+
+    obj.clear();
+    EXPECT_FALSE(obj.has("id1"));
+}
+
+struct BindUser {
+    int id = 0;
+    std::string name;
+    double score = 0;
+    bool admin = false;
+    std::vector<int> groups;
+};
+
+TEST(wrapidjsonTest, binding_test)
+{
+    static const auto binding = make_binding(
+        field("id", &BindUser::id),
+        field("name", &BindUser::name),
+        field("score", &BindUser::score, false),
+        field("admin", &BindUser::admin, false),
+        field("groups", &BindUser::groups, false));
+
+    Document doc(R"({"name":"wrapidjson","ignored":1,"id":7,"groups":[1,2],"admin":true,"id":8})");
+    BindUser user;
+    BindResult res = binding.decode(doc, user);
+    EXPECT_TRUE(res);
+    EXPECT_EQ(user.id, 7);
+    EXPECT_EQ(user.name, "wrapidjson");
+    EXPECT_EQ(user.score, 0);
+    EXPECT_TRUE(user.admin);
+    EXPECT_EQ(user.groups, (std::vector<int>{1, 2}));
+
+    EXPECT_EQ(binding.to_string(user),
+            R"({"id":7,"name":"wrapidjson","score":0.0,"admin":true,"groups":[1,2]})");
+
+    Document bad(R"({"id":"7","score":null,"admin":1})");
+    BindUser other;
+    res = binding.decode(bad, other);
+    EXPECT_FALSE(res);
+    EXPECT_EQ(res.missing, std::vector<std::string>{"name"});
+    EXPECT_EQ(res.invalid, (std::vector<std::string>{"id", "admin"}));
+
+    Document array("[1,2]");
+    res = binding.decode(array, other);
+    EXPECT_EQ(res.missing, (std::vector<std::string>{"id", "name"}));
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    EXPECT_TRUE(binding.encode(user, writer));
+    Document round(std::string(buffer.GetString()));
+    BindUser copy;
+    EXPECT_TRUE(binding.decode(round, copy));
+    EXPECT_EQ(copy.groups, user.groups);
+}
+
+struct SerTag {
+    std::string name;
+    int weight;
+};
+WRAPIDJSON_BIND(SerTag, name, weight)
+
+struct SerUser {
+    int64_t id;
+    std::string name;
+    nonstd::optional<std::string> email;
+    std::vector<SerTag> tags;
+    std::map<std::string, double> scores;
+    std::set<int> groups;
+};
+WRAPIDJSON_BIND_FIELDS(SerUser,
+    wrapidjson::field("user_id", &SerUser::id),
+    wrapidjson::field("name", &SerUser::name),
+    wrapidjson::field("email", &SerUser::email, false),
+    wrapidjson::field("tags", &SerUser::tags, false),
+    wrapidjson::field("scores", &SerUser::scores, false),
+    wrapidjson::field("groups", &SerUser::groups, false))
+
+TEST(wrapidjsonTest, serializer_test)
+{
+    SerUser user;
+    user.id = 7;
+    user.name = "wrapidjson";
+    user.tags = {SerTag{"a", 1}, SerTag{"b", 2}};
+    user.scores = {{"x", 1.5}};
+    user.groups = {3, 1};
+
+    // encode without DOM
+    std::string json = to_json(user);
+    EXPECT_EQ(json, R"({"user_id":7,"name":"wrapidjson","email":null,"tags":[{"name":"a","weight":1},)"
+            R"({"name":"b","weight":2}],"scores":{"x":1.5},"groups":[1,3]})");
+    std::string buffer = "[";
+    EXPECT_TRUE(append_json(std::vector<SerTag>{SerTag{"c", 3}}, buffer));
+    EXPECT_EQ(buffer, R"([[{"name":"c","weight":3}])");
+
+    // SAX decode round trip
+    SerUser sax;
+    BindResult res = from_json(json, sax);
+    EXPECT_TRUE(res);
+    EXPECT_EQ(sax.id, 7);
+    EXPECT_FALSE(sax.email);
+    ASSERT_EQ(sax.tags.size(), 2u);
+    EXPECT_EQ(sax.tags[1].name, "b");
+    EXPECT_EQ(sax.scores["x"], 1.5);
+    EXPECT_EQ(sax.groups, (std::set<int>{1, 3}));
+    EXPECT_EQ(to_json(sax), json);
+
+    // DOM decode follows the same traits
+    Document doc(json);
+    SerUser dom;
+    EXPECT_TRUE(wrapidjson_binding(&dom).decode(doc, dom));
+    EXPECT_EQ(to_json(dom), json);
+
+    // unknown members are skipped, errors are reported by path
+    std::istringstream is(R"({"name":"x","extra":{"a":[1,{}]},"email":"e@x",)"
+            R"("tags":[{"name":"a","weight":"1"},{"weight":2}],"user_id":-1})");
+    SerUser bad;
+    res = from_json(is, bad);
+    EXPECT_FALSE(res);
+    EXPECT_TRUE(res.error.empty());
+    EXPECT_EQ(res.invalid, std::vector<std::string>{"tags[0].weight"});
+    EXPECT_EQ(res.missing, std::vector<std::string>{"tags[1].name"});
+    EXPECT_EQ(*bad.email, "e@x");
+    EXPECT_EQ(bad.id, -1);
+
+    res = from_json("{\"user_id\":1,", bad);
+    EXPECT_FALSE(res.error.empty());
+
+    // make_binding without macro
+    static const auto binding = make_binding(field("id", &BindUser::id), field("name", &BindUser::name));
+    BindUser plain;
+    EXPECT_TRUE(from_json(R"({"id":3,"name":"plain"})", plain, binding));
+    EXPECT_EQ(plain.id, 3);
+    EXPECT_EQ(plain.name, "plain");
+}
+
+TEST(wrapidjsonTest, path_test)
+{
+    Document doc;
+    EXPECT_TRUE(doc.load_from_buffer(
+        "{\"a\":{\"b\":[1,2,{\"c\":\"x\"}]},\"m~n\":1,\"s/t\":2,"
+        " \"items\":[{\"price\":10},{\"name\":\"none\"},{\"price\":30}]}"));
+    std::string before = doc.to_string();
+
+    EXPECT_EQ(Path("/a/b/2/c").get(doc)->as<std::string>(), "x");
+    EXPECT_EQ(Path("/a/b/1").get(doc)->as<int>(), 2);
+    EXPECT_EQ(Path("/m~0n").get(doc)->as<int>(), 1);
+    EXPECT_EQ(Path("/s~1t").get(doc)->as<int>(), 2);
+    EXPECT_TRUE(Path("").get(doc)->is_object());
+    EXPECT_FALSE(Path("/a/x/c").get(doc));
+    EXPECT_FALSE(Path("/a/b/3").get(doc));
+    EXPECT_FALSE(Path("/a/b/01").get(doc));
+    EXPECT_THROW(Path("a/b"), std::runtime_error);
+    EXPECT_THROW(Path("/a~2"), std::runtime_error);
+
+    Path prices("/items/*/price");
+    EXPECT_TRUE(prices.has_wildcard());
+    EXPECT_EQ(prices.get(doc)->as<int>(), 10);
+    auto all = prices.select(doc);
+    ASSERT_EQ(all.size(), 2u);
+    EXPECT_EQ(all[0].as<int>(), 10);
+    EXPECT_EQ(all[1].as<int>(), 30);
+
+    PathSet paths;
+    size_t c = paths.add("/a/b/2/c");
+    size_t b0 = paths.add("/a/b/0");
+    size_t missing = paths.add("/a/z");
+    size_t price = paths.add(prices);
+    EXPECT_EQ(paths.size(), 4u);
+    auto values = paths.get(doc);
+    EXPECT_EQ(values[c]->as<std::string>(), "x");
+    EXPECT_EQ(values[b0]->as<int>(), 1);
+    EXPECT_FALSE(values[missing]);
+    EXPECT_EQ(values[price]->as<int>(), 10);
+    EXPECT_EQ(paths.select(doc)[price].size(), 2u);
+
+    // read only
+    EXPECT_EQ(before, doc.to_string());
+}
+
+TEST(wrapidjsonTest, string_view_get)
+{
+    std::string json = R"({"name":"wrapidjson","id":1})";
+    Document doc(json);
+
+    string_view name = doc["name"].as<string_view>();
+    EXPECT_EQ(name, "wrapidjson");
+    EXPECT_EQ(name.data(), doc["name"].get_rvalue().GetString());   // no copy
+    EXPECT_TRUE(doc["id"].as<string_view>().empty());
+
+    EXPECT_EQ(*doc["name"].get<string_view>(), "wrapidjson");
+    EXPECT_FALSE(doc["id"].get<string_view>());
+
+    auto obj = doc.get_object();
+    EXPECT_EQ(*obj.get_value<string_view>("name"), "wrapidjson");
+    EXPECT_EQ(*obj.get_value<string_view>("name"_key), "wrapidjson");
+    EXPECT_FALSE(obj.get_value<string_view>("id"));
+
+    // string_view keys
+    string_view key = string_view(json).substr(2, 4);
+    EXPECT_TRUE(obj.has(key));
+    EXPECT_TRUE(doc.has(key));
+    EXPECT_EQ(obj.count(key), 1);
+    EXPECT_TRUE(doc.find(key));
+    EXPECT_EQ(*obj.get_value<std::string>(key), "wrapidjson");
+}
+
+TEST(wrapidjsonTest, numeric_string_conversion)
+{
+    Document doc(R"({"int":"-2147483648","big":"18446744073709551615","over":"18446744073709551616",
+        "long":"12345678901234567","double":"0.30000000000000004","exp":"-1.5E-3","bool":"TRUE",
+        "bad":"12abc","space":"  42"})");
+
+    EXPECT_EQ(doc["int"].as<int>(), -2147483648);
+    EXPECT_EQ(doc["big"].as<uint64_t>(), 18446744073709551615ull);
+    EXPECT_EQ(doc["over"].as<uint64_t>(), 0u);
+    EXPECT_EQ(doc["long"].as<int64_t>(), 12345678901234567ll);
+    EXPECT_EQ(doc["double"].as<double>(), 0.30000000000000004);
+    EXPECT_EQ(doc["exp"].as<double>(), -1.5e-3);
+    EXPECT_TRUE(doc["bool"].as<bool>());
+    EXPECT_EQ(doc["bad"].as<int>(), 0);
+    EXPECT_EQ(doc["space"].as<int>(), 42);
+
+    EXPECT_FALSE(detail::parse<int>("2147483648"));
+    EXPECT_FALSE(detail::parse<unsigned>("-1"));
+    EXPECT_EQ(*detail::parse<int8_t>("-128"), -128);
+    EXPECT_EQ(*detail::parse<double>(".5"), 0.5);
+    EXPECT_FALSE(detail::parse<double>("1e400"));    // out of range like strtod
+    EXPECT_TRUE(std::isnan(*detail::parse<double>("NaN")));
+    EXPECT_FALSE(detail::parse<double>("1e"));
+    EXPECT_FALSE(detail::parse<bool>("yes"));
+
+    // shortest round trip
+    doc["d1"] = 12.34;
+    doc["d2"] = 0.1 + 0.2;
+    doc["d3"] = 1e300;
+    EXPECT_EQ(doc["d1"].as<std::string>(), "12.34");
+    EXPECT_EQ(doc["d2"].as<std::string>(), "0.30000000000000004");
+    EXPECT_EQ(doc["d3"].as<std::string>(), "1e300");
+}
+
+TEST(wrapidjsonTest, lazy_document)
+{
+    LazyDocument msg;
+    EXPECT_FALSE(msg.load_from_buffer("{\"a\":1,"));
+    EXPECT_FALSE(msg.get_load_error().empty());
+
+    EXPECT_TRUE(msg.load_from_buffer(
+        "{ \"type\" : \"route\", \"hops\": 1, \"body\": {\"x\": [1, 2, {\"y\":\"}\"}]}, \"k\\\"q\": true }"));
+    EXPECT_TRUE(msg.is_object());
+    EXPECT_EQ(msg.size(), 4u);
+    auto body = msg.raw("body");
+    ASSERT_TRUE(body);
+    EXPECT_EQ(std::string(body->data(), body->size()), "{\"x\": [1, 2, {\"y\":\"}\"}]}");
+    EXPECT_TRUE(msg.has("k\"q"));
+    EXPECT_FALSE(msg.has("none"));
+    EXPECT_FALSE(msg.find("none"));
+    EXPECT_EQ(msg.find("type")->as<std::string>(), "route");
+
+    // untouched values are copied as is
+    EXPECT_EQ(msg.to_string(), "{\"type\":\"route\",\"hops\":1,\"body\":{\"x\": [1, 2, {\"y\":\"}\"}]},\"k\\\"q\":true}");
+    *msg.find("hops") = 2;
+    EXPECT_EQ(msg.to_string(), "{\"type\":\"route\",\"hops\":2,\"body\":{\"x\": [1, 2, {\"y\":\"}\"}]},\"k\\\"q\":true}");
+
+    // root keeps materialized edits
+    EXPECT_EQ(msg.root()["hops"].as<int>(), 2);
+    EXPECT_EQ(msg.root()["body"]["x"][1].as<int>(), 2);
+    EXPECT_EQ(msg.find("type")->as<std::string>(), "route");
+
+    LazyDocument list;
+    EXPECT_TRUE(list.load_from_buffer("[1, {\"a\":2}, \"s\"]"));
+    EXPECT_TRUE(list.is_array());
+    EXPECT_EQ(list.at(1)->get_object().get_value<int>("a"), 2);
+    EXPECT_FALSE(list.at(3));
+    EXPECT_EQ(list.to_string(), "[1,{\"a\":2},\"s\"]");
+
+    LazyDocument scalar;
+    EXPECT_TRUE(scalar.load_from_buffer(" 42 "));
+    EXPECT_EQ(scalar.size(), 0u);
+    EXPECT_EQ(scalar.to_string(), "42");
+}
+
+TEST(wrapidjsonTest, load_insitu)
+{
+    Document doc;
+    std::string json = R"({"name":"wrapidjson","list":["a","b"]})";
+    EXPECT_TRUE(doc.load_from_buffer_insitu(std::move(json)));
+    EXPECT_EQ(doc["name"].as<std::string>(), "wrapidjson");
+    EXPECT_EQ(doc["list"].size(), 2u);
+
+    char buffer[] = R"({"key":"value"})";
+    EXPECT_TRUE(doc.load_from_buffer_insitu(buffer));
+    EXPECT_EQ(doc["key"].as<std::string>(), "value");
+
+    EXPECT_FALSE(doc.load_from_buffer_insitu(std::string(R"({"key":)")));
+
+    // failed reload keeps old root and the storage its strings point into
+    EXPECT_TRUE(doc.load_from_buffer_insitu(std::string(R"({"kept":["in","situ"]})")));
+    EXPECT_FALSE(doc.load_from_buffer("[1,"));
+    EXPECT_FALSE(doc.load_from_buffer_insitu(std::string("{\"x\":")));
+    EXPECT_EQ(doc.to_string(), R"({"kept":["in","situ"]})");
+
+    std::string frame = R"([1,2,3]garbage)";
+    EXPECT_TRUE(doc.load_from_buffer(string_view(frame.data(), 7)));
+    EXPECT_EQ(doc.size(), 3u);
+    EXPECT_FALSE(doc.load_from_buffer(string_view(frame)));
+}
+
+TEST(wrapidjsonTest, load_flags)
+{
+    Document doc;
+    EXPECT_TRUE(doc.load_from_buffer<rapidjson::kParseNumbersAsStringsFlag>("{\"n\":1.000000000000000000001}"));
+    EXPECT_TRUE(doc["n"].is_string());
+    EXPECT_EQ(doc["n"].as<std::string>(), "1.000000000000000000001");
+
+    EXPECT_FALSE(doc.load_from_buffer("{/* comment */\"a\":1}"));
+    EXPECT_TRUE(doc.load_from_buffer<rapidjson::kParseCommentsFlag>(std::string("{/* comment */\"a\":1}")));
+    EXPECT_EQ(doc["a"].as<int>(), 1);
+
+    // framed stream : one value per load
+    std::stringstream framed("{\"a\":1} {\"a\":2}");
+    EXPECT_TRUE(doc.load_from_stream<rapidjson::kParseStopWhenDoneFlag>(framed));
+    EXPECT_EQ(doc["a"].as<int>(), 1);
+    EXPECT_TRUE(doc.load_from_stream<rapidjson::kParseStopWhenDoneFlag>(framed));
+    EXPECT_EQ(doc["a"].as<int>(), 2);
+
+    std::string deep = std::string(10000, '[') + std::string(10000, ']');
+    EXPECT_TRUE(doc.load_from_buffer<rapidjson::kParseIterativeFlag>(string_view(deep)));
+    EXPECT_FALSE(doc.load_from_buffer<rapidjson::kParseIterativeFlag>("[[]"));
+
+    EXPECT_TRUE(doc.load_from_buffer_insitu<rapidjson::kParseNumbersAsStringsFlag>(std::string("[12345678901234567890123]")));
+    EXPECT_EQ(doc.get_array()[0].as<std::string>(), "12345678901234567890123");
+}
+
+TEST(wrapidjsonTest, arena_reset)
+{
+    Arena arena(1024);
+    Document doc(arena);
+
+    std::string large = "[";
+    for (int i = 0; i < 1000; ++i) {
+        large += (i ? ",\"" : "\"") + std::to_string(i) + "\"";
+    }
+    large += "]";
+
+    EXPECT_TRUE(doc.load_from_buffer(large));
+    EXPECT_EQ(doc.size(), 1000u);
+    size_t high_water = arena.capacity();
+    EXPECT_GT(high_water, 1024u);
+
+    doc.reset();
+    EXPECT_TRUE(doc.is_null());
+    EXPECT_EQ(arena.size(), 0u);
+
+    // grown block fits the same message without overflow chunk
+    size_t grown = arena.capacity();
+    EXPECT_GE(grown, high_water);
+    EXPECT_TRUE(doc.load_from_buffer(large));
+    EXPECT_EQ(doc.size(), 1000u);
+    EXPECT_EQ(arena.capacity(), grown);
+
+    char buffer[4096];
+    Arena stack_arena(buffer, sizeof(buffer));
+    Document stack_doc(stack_arena);
+    EXPECT_TRUE(stack_doc.load_from_buffer(R"({"a":[1,2,3]})"));
+    EXPECT_EQ(stack_doc["a"].size(), 3u);
+    stack_doc.reset();
+    EXPECT_EQ(stack_arena.size(), 0u);
+}
+
+TEST(wrapidjsonTest, stream_test)
+{
+    std::string json = R"({"a":[1,2,3],"b":{"c":"d"},"e":"fghijklmnop"})";
+    for (size_t buffer_size : {1u, 3u, 7u, 4096u}) {
+        Document doc;
+        std::stringstream in(json);
+        EXPECT_TRUE(doc.load_from_stream(in, buffer_size));
+        EXPECT_EQ(doc["a"].size(), 3u);
+        EXPECT_EQ(doc["b"]["c"].as<std::string>(), "d");
+
+        std::stringstream out;
+        EXPECT_TRUE(doc.save_to_stream(out, false, buffer_size));
+        EXPECT_EQ(out.str(), json);
+    }
+
+    Document doc;
+    std::stringstream broken(R"({"a1":["a","b","c","d","e"])");
+    EXPECT_FALSE(doc.load_from_stream(broken, 4));
+#if RAPIDJSON_MAJOR_VERSION >= 1 && RAPIDJSON_MINOR_VERSION > 0
+    EXPECT_EQ(doc.get_load_error(), "Error offset[27]: Missing a comma or '}' after an object member.");
+#else
+    EXPECT_EQ(doc.get_load_error(), "Error offset[28]: Missing a comma or '}' after an object member.");
+#endif
+}
+
+/// non seekable streambuf, one frame per underflow ( in_avail ends at frame boundary )
+struct FrameBuf : std::streambuf {
+    std::vector<std::string> frames;
+    size_t next = 0;
+    int underflows = 0;
+
+    int_type underflow() override {
+        ++underflows;
+        if (next == frames.size()) {
+            return traits_type::eof();      // a socket would block here
+        }
+        std::string& frame = frames[next++];
+        setg(&frame[0], &frame[0], &frame[0] + frame.size());
+        return traits_type::to_int_type(frame[0]);
+    }
+};
+
+TEST(wrapidjsonTest, stream_frame_boundary)
+{
+    FrameBuf framebuf;
+    framebuf.frames = {R"({"a":[1,2]})", R"({"b":"c"})"};
+    std::istream in(&framebuf);
+
+    Document doc;
+    EXPECT_TRUE(doc.load_from_stream<rapidjson::kParseStopWhenDoneFlag>(in, 4));
+    EXPECT_EQ(doc["a"].size(), 2u);
+    EXPECT_EQ(framebuf.underflows, 1);      // next frame is not waited for
+
+    EXPECT_TRUE(doc.load_from_stream<rapidjson::kParseStopWhenDoneFlag>(in));
+    EXPECT_EQ(doc["b"].as<std::string>(), "c");
+    EXPECT_EQ(framebuf.underflows, 2);
+}
+
+TEST(wrapidjsonTest, load_from_mmap)
+{
+    const std::string path = "wrapidjson_mmap_test.json";
+    std::string json = R"({"name":"mmap","values":[1,2,3]})";
+    {
+        std::ofstream ofs(path);
+        ofs << json;
+    }
+
+    for (bool insitu : {false, true}) {
+        Document doc;
+        EXPECT_TRUE(doc.load_from_mmap(path, insitu));
+        EXPECT_EQ(doc["name"].as<std::string>(), "mmap");
+        EXPECT_EQ(doc["values"].size(), 3u);
+    }
+
+    // private mapping never writes back
+    Document file_doc;
+    EXPECT_TRUE(file_doc.load_from_file(path));
+    EXPECT_EQ(file_doc["name"].as<std::string>(), "mmap");
+
+    Document doc;
+    EXPECT_FALSE(doc.load_from_mmap("wrapidjson_not_exist.json"));
+
+    // failed reloads keep the mapping the in-situ root points into
+    const std::string broken_path = "wrapidjson_mmap_broken.json";
+    {
+        std::ofstream ofs(broken_path);
+        ofs << R"({"name":)";
+    }
+    EXPECT_TRUE(doc.load_from_mmap(path, true));
+    EXPECT_FALSE(doc.load_from_mmap(broken_path, true));
+    EXPECT_FALSE(doc.load_from_mmap(broken_path));
+    EXPECT_FALSE(doc.load_from_file(broken_path));
+    std::stringstream broken_stream(R"([1,)");
+    EXPECT_FALSE(doc.load_from_stream(broken_stream));
+    EXPECT_EQ(doc.to_string(), json);
+    std::remove(broken_path.c_str());
+    std::remove(path.c_str());
+}
+
+TEST(wrapidjsonTest, reader_test)
+{
+    class IdCollector : public ReaderHandler {
+    public:
+        ReadAction on_key(const string_view& key) override {
+            is_id_ = (key == "id");
+            return key == "payload" ? ReadAction::SKIP : ReadAction::CONTINUE;
+        }
+        ReadAction on_value(const ValueRef& value) override {
+            ++values;
+            if (is_id_) {
+                ids.push_back(value.as<int>());
+            }
+            return ids.size() == limit ? ReadAction::STOP : ReadAction::CONTINUE;
+        }
+        ReadAction on_start_object() override { ++objects; return ReadAction::CONTINUE; }
+
+        std::vector<int> ids;
+        size_t values = 0;
+        size_t objects = 0;
+        size_t limit = 0;
+    private:
+        bool is_id_ = false;
+    };
+
+    std::string json = R"([{"id":1,"payload":{"a":[1,2,3]}},{"id":"2","payload":[{"b":1}]},{"id":3}])";
+
+    Reader reader;
+    IdCollector all;
+    EXPECT_TRUE(reader.read_from_buffer(json, all));
+    EXPECT_EQ(all.ids, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(all.values, 3u);      // payload values are skipped
+    EXPECT_EQ(all.objects, 3u);
+
+    IdCollector first;
+    first.limit = 1;
+    std::stringstream ss(json);
+    EXPECT_FALSE(reader.read_from_stream(ss, first));
+    EXPECT_TRUE(reader.stopped());
+    EXPECT_EQ(first.ids, std::vector<int>{1});
+
+    IdCollector broken;
+    EXPECT_FALSE(reader.read_from_buffer(R"([{"id":1},)", broken));
+    EXPECT_FALSE(reader.stopped());
+    EXPECT_EQ(reader.get_read_error(), "Error offset[10]: Invalid value.");
+}
+
+TEST(wrapidjsonTest, simd_scan)
+{
+    using namespace wrapidjson::detail::simd;
+    EXPECT_NE(kernels().name, nullptr);
+
+    std::string text(1000, 'a');
+    text += "\xe4\xbd\xa0\xe5\xa5\xbd\xf0\x9f\x98\x80";
+    text += std::string(100, 'b');
+    EXPECT_TRUE(validate_utf8(text.data(), text.size()));
+    std::string bad = text;
+    bad[1003] = '\xff';
+    EXPECT_EQ(find_invalid_utf8(bad.data(), bad.size()), 1003u);
+    EXPECT_FALSE(validate_utf8("\xc0\x80", 2));           // overlong
+    EXPECT_FALSE(validate_utf8("\xed\xa0\x80", 3));       // surrogate
+    EXPECT_FALSE(validate_utf8("\xf4\x90\x80\x80", 4));   // > U+10FFFF
+    EXPECT_FALSE(validate_utf8("\xe4\xbd", 2));           // truncated
+
+    std::string scan(70, 'x');
+    scan[65] = '\\';
+    scan[40] = '}';
+    const char* end = scan.data() + scan.size();
+    EXPECT_EQ(find_quote_or_escape(scan.data(), end), scan.data() + 65);
+    EXPECT_EQ(find_structural(scan.data(), end), scan.data() + 40);
+    EXPECT_EQ(find_structural(scan.data() + 41, end), end);
+
+    // first stage of lazy mode and streaming reader
+    std::string json = "{\"k\":\"" + std::string(100, 'v') + "\xff\"}";
+    LazyDocument lazy;
+    EXPECT_FALSE(lazy.load_from_buffer(json));
+    ReaderHandler handler;
+    EXPECT_TRUE(Reader().read_from_buffer(json, handler));
+    EXPECT_FALSE(Reader(true).read_from_buffer(json, handler));
+}
+
+TEST(wrapidjsonTest, ndjson_test)
+{
+    std::string ndjson = "{\"id\":1}\n{\"id\":2}\r\n\n  \n{\"id\":3}";
+    std::vector<int> ids;
+    auto collect = [&ids](Document& doc) {
+        ids.push_back(doc["id"].as<int>());
+        return true;
+    };
+
+    NdjsonReader reader;
+    EXPECT_TRUE(reader.read_from_buffer(ndjson, collect));
+    EXPECT_EQ(ids, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(reader.count(), 3u);
+    EXPECT_EQ(reader.line(), 5u);
+
+    ids.clear();
+    std::stringstream ss(ndjson);
+    EXPECT_TRUE(reader.read_from_stream(ss, collect));
+    EXPECT_EQ(ids, (std::vector<int>{1, 2, 3}));
+
+    // stop early by callback
+    ids.clear();
+    EXPECT_TRUE(reader.read_from_buffer(ndjson, [&ids](Document& doc) {
+        ids.push_back(doc["id"].as<int>());
+        return false;
+    }));
+    EXPECT_EQ(ids, std::vector<int>{1});
+
+    // error with line and offset
+    std::string broken = "{\"id\":1}\n{\"id\":}\n{\"id\":3}\n";
+    ids.clear();
+    EXPECT_FALSE(reader.read_from_buffer(broken, collect));
+    EXPECT_EQ(ids, std::vector<int>{1});
+    EXPECT_EQ(reader.error_line(), 2u);
+    EXPECT_EQ(reader.error_offset(), 15u);
+    EXPECT_EQ(reader.get_read_error(), "Error line[2] offset[15]: Invalid value.");
+
+    NdjsonReader lenient(false);
+    ids.clear();
+    EXPECT_FALSE(lenient.read_from_buffer(broken, collect));
+    EXPECT_EQ(ids, (std::vector<int>{1, 3}));
+    EXPECT_EQ(lenient.error_count(), 1u);
+}
+
+TEST(wrapidjsonTest, parallel_ndjson_test)
+{
+    std::string data;
+    for (int i = 1; i <= 1000; ++i) {
+        data += "{\"id\":" + std::to_string(i) + "}\n";
+    }
+
+    // tiny chunks, so every thread gets a part
+    ParallelNdjsonReader reader(4, true, 64);
+    std::vector<int> ids;
+    EXPECT_TRUE(reader.transform_from_buffer<int>(data, [](Document& doc) {
+        return doc["id"].as<int>();
+    }, ids));
+    ASSERT_EQ(ids.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(ids[i], i + 1);
+    }
+    EXPECT_EQ(reader.line(), 1000u);
+    EXPECT_EQ(reader.count(), 1000u);
+
+    std::atomic<long> sum(0);
+    EXPECT_TRUE(reader.read_from_buffer(data, [&sum](Document& doc) {
+        sum += doc["id"].as<int>();
+        return true;
+    }));
+    EXPECT_EQ(sum.load(), 500500);
+
+    // error line and offset are global
+    std::string broken = data;
+    size_t pos = broken.find("{\"id\":700}");
+    broken.replace(pos, 10, "{\"id\":  }");
+    EXPECT_FALSE(reader.transform_from_buffer<int>(broken, [](Document& doc) {
+        return doc["id"].as<int>();
+    }, ids));
+    EXPECT_EQ(reader.error_line(), 700u);
+    EXPECT_EQ(reader.error_offset(), pos + 8);
+
+    // stop_on_error : ends at invalid record every run, same as NdjsonReader
+    NdjsonReader serial;
+    EXPECT_FALSE(serial.read_from_buffer(broken, [](Document&) { return true; }));
+    for (int run = 0; run < 20; ++run) {
+        EXPECT_FALSE(reader.transform_from_buffer<int>(broken, [](Document& doc) {
+            return doc["id"].as<int>();
+        }, ids));
+        ASSERT_EQ(ids.size(), 699u);
+        EXPECT_EQ(ids.back(), 699);
+        EXPECT_EQ(reader.line(), serial.line());
+        EXPECT_EQ(reader.count(), serial.count());
+        EXPECT_EQ(reader.error_count(), serial.error_count());
+    }
+
+    ParallelNdjsonReader lenient(4, false, 64);
+    EXPECT_FALSE(lenient.transform_from_buffer<int>(broken, [](Document& doc) {
+        return doc["id"].as<int>();
+    }, ids));
+    EXPECT_EQ(ids.size(), 999u);
+    EXPECT_EQ(lenient.error_count(), 1u);
+    EXPECT_EQ(lenient.error_line(), 700u);
+}
@@ -0,0 +1,105 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_ARENA_H_
+#define WRAPIDJSON_ARENA_H_
+
+#include <memory>
+#include <new>
+
+#include <rapidjson/document.h>
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Reusable memory arena for Document
+///  - Arena(capacity)     : arena owns a heap block, grows it on reset() when exceeded
+///  - Arena(buffer, size) : caller buffer ( stack, thread_local ), never grows
+/// Arena must outlive every Document that uses it.
+/// Document::reset() resets the whole arena, share one only between Documents reset together.
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Arena {
+public:
+    using AllocatorType = rapidjson::Document::AllocatorType;
+    static const size_t DEFAULT_CAPACITY = 65536;
+    static const size_t MIN_CAPACITY = 256;
+
+    explicit Arena(size_t capacity = DEFAULT_CAPACITY)
+        : owned_(new char[fit(capacity)])
+        , buffer_(owned_.get())
+        , size_(fit(capacity))
+        , allocator_(buffer_, size_)
+    {}
+
+    Arena(void* buffer, size_t size)
+        : buffer_(buffer), size_(size), allocator_(buffer_, size_)
+    {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() = default;
+
+    /// get the actual rapidjson allocator by reference
+    AllocatorType& get_allocator() { return allocator_; }
+
+    /// total bytes of chunks ( first block + overflow chunks )
+    size_t capacity() const { return allocator_.Capacity(); }
+
+    /// used bytes
+    size_t size() const { return allocator_.Size(); }
+
+    /// release every allocation, first block is kept.
+    /// owned arena grows first block to fit the previous high-water mark,
+    /// so steady state messages are served without malloc.
+    void reset() {
+        if (owned_ and allocator_.Capacity() > size_) {
+            size_t new_size = size_;
+            while (new_size <= allocator_.Capacity()) {
+                new_size *= 2;
+            }
+            // allocate first, a throwing new must leave allocator_ alive for ~Arena
+            std::unique_ptr<char[]> block(new char[new_size]);
+            // rapidjson::Document keeps a pointer to allocator_, so rebuild it in place
+            allocator_.~AllocatorType();
+            new (&allocator_) AllocatorType(block.get(), new_size);
+            owned_ = std::move(block);
+            buffer_ = owned_.get();
+            size_ = new_size;
+        } else {
+            allocator_.Clear();
+        }
+    }
+
+private:
+    static size_t fit(size_t capacity) {
+        return capacity < MIN_CAPACITY ? static_cast<size_t>(MIN_CAPACITY) : capacity;
+    }
+
+    std::unique_ptr<char[]> owned_;
+    void*                   buffer_;
+    size_t                  size_;
+    AllocatorType           allocator_;
+};
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_ARENA_H_
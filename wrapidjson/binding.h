@@ -0,0 +1,425 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_BINDING_H_
+#define WRAPIDJSON_BINDING_H_
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <bitset>
+#include <type_traits>
+
+#include <rapidjson/writer.h>
+
+#include "document.h"
+#include "key.h"
+#include "writer.h"
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Result of Binding::decode / from_json
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct BindResult {
+    std::vector<std::string> missing;   // required fields not in object
+    std::vector<std::string> invalid;   // fields of wrong type ( member is unchanged )
+    std::string              error;     // parse error of from_json
+
+    bool ok() const { return missing.empty() and invalid.empty() and error.empty(); }
+    explicit operator bool() const { return ok(); }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// JSON key and struct member
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T, typename M>
+struct Field {
+    Key         key;
+    M T::*      member;
+    bool        required;
+};
+
+template<size_t N, typename T, typename M>
+constexpr Field<T, M> field(const char (&name)[N], M T::* member, bool required = true) {
+    return Field<T, M>{Key(name), member, required};
+}
+
+template<typename T, typename M>
+constexpr Field<T, M> field(const Key& key, M T::* member, bool required = true) {
+    return Field<T, M>{key, member, required};
+}
+
+namespace detail {
+
+/// user type bound by WRAPIDJSON_BIND ( serializer.h ), found by argument dependent lookup
+template<typename T, typename = void>
+struct has_binding : std::false_type {};
+
+template<typename T>
+struct has_binding<T, void_t<decltype(wrapidjson_binding(static_cast<const T*>(nullptr)))>>
+    : std::true_type {};
+
+template<typename T>
+struct is_optional : std::false_type {};
+
+template<typename T>
+struct is_optional<nonstd::optional<T>> : std::true_type {};
+
+/// iterable that is written as JSON array
+template<typename T>
+struct is_sequence : std::integral_constant<bool,
+    is_array_container<T>::value and not has_binding<T>::value> {};
+
+/// scalar to Writer
+template<typename Writer>
+inline bool encode_scalar(Writer& writer, bool value) {
+    return writer.Bool(value);
+}
+
+template<typename Writer>
+inline bool encode_scalar(Writer& writer, char value) {
+    return writer.String(&value, 1);
+}
+
+template<typename Writer, typename M,
+    enable_if_t<std::is_integral<M>::value and std::is_signed<M>::value>* = nullptr>
+inline bool encode_scalar(Writer& writer, M value) {
+    return writer.Int64(static_cast<int64_t>(value));
+}
+
+template<typename Writer, typename M,
+    enable_if_t<std::is_integral<M>::value and std::is_unsigned<M>::value and
+        not std::is_same<M, bool>::value>* = nullptr>
+inline bool encode_scalar(Writer& writer, M value) {
+    return writer.Uint64(static_cast<uint64_t>(value));
+}
+
+template<typename Writer, typename M, enable_if_t<std::is_floating_point<M>::value>* = nullptr>
+inline bool encode_scalar(Writer& writer, M value) {
+    return writer.Double(static_cast<double>(value));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Codec<M> : member type to JSON, selected at compile time from type traits
+///  - decode(value, out) : DOM value to out ( ValueRef::get<M> rules ), out is unchanged on false
+///  - encode(writer, in) : write in to rapidjson Writer / PrettyWriter
+/// arithmetic, std::string, string_view, nonstd::optional, sequences, std::string keyed maps
+/// and WRAPIDJSON_BIND types, nested to any depth
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename M, typename Enable = void>
+struct Codec;
+
+template<typename M>
+struct Codec<M, enable_if_t<std::is_arithmetic<M>::value or is_string<M>::value or
+        is_string_view<M>::value>> {
+    static bool decode(const ValueRef& value, M& out) {
+        auto res = value.get<M>();
+        if (not res) {
+            return false;
+        }
+        out = std::move(*res);
+        return true;
+    }
+
+    template<typename Writer>
+    static bool encode(Writer& writer, const M& in) {
+        return encode(writer, in, std::is_arithmetic<M>());
+    }
+
+    template<typename Writer>
+    static bool encode(Writer& writer, const M& in, std::true_type) {
+        return encode_scalar(writer, in);
+    }
+
+    template<typename Writer>
+    static bool encode(Writer& writer, const M& in, std::false_type) {
+        return writer.String(in.data(), static_cast<rapidjson::SizeType>(in.size()));
+    }
+};
+
+/// null is empty optional
+template<typename M>
+struct Codec<nonstd::optional<M>> {
+    static bool decode(const ValueRef& value, nonstd::optional<M>& out) {
+        if (value.is_null()) {
+            out = nonstd::nullopt;
+            return true;
+        }
+        M item;
+        if (not Codec<M>::decode(value, item)) {
+            return false;
+        }
+        out = std::move(item);
+        return true;
+    }
+
+    template<typename Writer>
+    static bool encode(Writer& writer, const nonstd::optional<M>& in) {
+        return in ? Codec<M>::encode(writer, *in) : writer.Null();
+    }
+};
+
+/// vector of bool / number is converted in bulk ( ArrayRef::get_vector )
+template<typename M>
+inline bool decode_items(const ArrayRef& array, std::vector<M>& out, std::true_type) {
+    return array.get_vector(out);
+}
+
+template<typename C>
+inline bool decode_items(const ArrayRef& array, C& out, std::false_type) {
+    C result;
+    for (size_t i = 0; i < array.size(); ++i) {
+        typename C::value_type item;
+        if (not Codec<typename C::value_type>::decode(array[i], item)) {
+            return false;
+        }
+        result.insert(result.end(), std::move(item));
+    }
+    out.swap(result);
+    return true;
+}
+
+template<typename C>
+struct is_bulk_vector : std::false_type {};
+
+template<typename M>
+struct is_bulk_vector<std::vector<M>> : is_bulk_element<M> {};
+
+template<typename C>
+struct Codec<C, enable_if_t<is_sequence<C>::value>> {
+    static bool decode(const ValueRef& value, C& out) {
+        if (not value.is_array()) {
+            return false;
+        }
+        return decode_items(ArrayRef(value), out, is_bulk_vector<C>());
+    }
+
+    template<typename Writer>
+    static bool encode(Writer& writer, const C& in) {
+        bool ret = writer.StartArray();
+        rapidjson::SizeType count = 0;
+        for (auto it = in.begin(); ret and it != in.end(); ++it, ++count) {
+            ret = Codec<typename C::value_type>::encode(writer, *it);
+        }
+        return ret and writer.EndArray(count);
+    }
+};
+
+template<typename C>
+struct Codec<C, enable_if_t<is_string_map<C>::value>> {
+    static bool decode(const ValueRef& value, C& out) {
+        if (not value.is_object()) {
+            return false;
+        }
+        C result;
+        ObjectRef object(value);
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            MemberRef member = *it;
+            const rapidjson::Value& name = member.name.get_rvalue();
+            typename C::mapped_type item;
+            if (not Codec<typename C::mapped_type>::decode(member.value, item)) {
+                return false;
+            }
+            result.emplace(std::string(name.GetString(), name.GetStringLength()), std::move(item));
+        }
+        out.swap(result);
+        return true;
+    }
+
+    template<typename Writer>
+    static bool encode(Writer& writer, const C& in) {
+        bool ret = writer.StartObject();
+        rapidjson::SizeType count = 0;
+        for (auto it = in.begin(); ret and it != in.end(); ++it, ++count) {
+            ret = writer.Key(it->first.data(), static_cast<rapidjson::SizeType>(it->first.size())) and
+                Codec<typename C::mapped_type>::encode(writer, it->second);
+        }
+        return ret and writer.EndObject(count);
+    }
+};
+
+/// nested struct is valid when its own decode has no missing / invalid field
+template<typename T>
+struct Codec<T, enable_if_t<has_binding<T>::value>> {
+    static bool decode(const ValueRef& value, T& out) {
+        return wrapidjson_binding(static_cast<const T*>(nullptr)).decode(value, out).ok();
+    }
+
+    template<typename Writer>
+    static bool encode(Writer& writer, const T& in) {
+        return wrapidjson_binding(static_cast<const T*>(nullptr)).encode(in, writer);
+    }
+};
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Struct binding ( declare fields once, decode in one pass over members )
+///  - members may be nested Codec types : optional, sequences, string keyed maps, bound structs
+///
+///   struct User { int id; std::string name; std::vector<int> groups; };
+///   static const auto user_binding = make_binding(
+///       field("id", &User::id), field("name", &User::name), field("groups", &User::groups, false));
+///
+///   User user;
+///   BindResult res = user_binding.decode(doc, user);
+///   user_binding.encode(user, writer);
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T, typename... Ms>
+class Binding {
+public:
+    static const size_t FIELD_COUNT = sizeof...(Ms);
+
+    explicit Binding(const Field<T, Ms>&... fields)
+        : fields_(fields...), keys_{fields.key...}, required_{fields.required...}
+    {
+        size_t size = 8;
+        while (size < FIELD_COUNT * 2) {
+            size *= 2;
+        }
+        slots_.assign(size, 0);
+        mask_ = size - 1;
+        for (size_t i = 0; i < FIELD_COUNT; ++i) {
+            size_t s = keys_[i].hash() & mask_;
+            while (slots_[s] != 0) {
+                s = (s + 1) & mask_;
+            }
+            slots_[s] = i + 1;
+        }
+    }
+
+    /// fill out from object members ( duplicate names : first member is used )
+    BindResult decode(const ObjectRef& object, T& out) const {
+        BindResult result;
+        std::bitset<FIELD_COUNT == 0 ? 1 : FIELD_COUNT> seen;
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            MemberRef member = *it;
+            const rapidjson::Value& name = member.name.get_rvalue();
+            size_t i = lookup(name.GetString(), name.GetStringLength());
+            if (i == FIELD_COUNT or seen[i]) {
+                continue;
+            }
+            seen[i] = true;
+            if (member.value.is_null() and not required_[i]) {
+                continue;
+            }
+            if (not decode_at<0>(i, member.value, out)) {
+                result.invalid.push_back(keys_[i].str());
+            }
+        }
+        for (size_t i = 0; i < FIELD_COUNT; ++i) {
+            if (not seen[i] and required_[i]) {
+                result.missing.push_back(keys_[i].str());
+            }
+        }
+        return result;
+    }
+
+    /// value must be object, otherwise every required field is missing
+    BindResult decode(const ValueRef& value, T& out) const {
+        if (value.is_object()) {
+            return decode(ObjectRef(value), out);
+        }
+        BindResult result;
+        for (size_t i = 0; i < FIELD_COUNT; ++i) {
+            if (required_[i]) {
+                result.missing.push_back(keys_[i].str());
+            }
+        }
+        return result;
+    }
+
+    /// write struct as JSON object to rapidjson Writer / PrettyWriter
+    template<typename Writer>
+    bool encode(const T& in, Writer& writer) const {
+        return writer.StartObject() and encode_from<0>(in, writer) and
+            writer.EndObject(static_cast<rapidjson::SizeType>(FIELD_COUNT));
+    }
+
+    std::string to_string(const T& in) const {
+        std::string buffer;
+        detail::StringOStream os(buffer);
+        rapidjson::Writer<detail::StringOStream> writer(os);
+        encode(in, writer);
+        return buffer;
+    }
+
+    /// field index of JSON key, FIELD_COUNT if key is not bound
+    size_t find_field(const char* name, size_t length) const { return lookup(name, length); }
+    const Key& key(size_t i) const { return keys_[i]; }
+    bool required(size_t i) const { return required_[i]; }
+    const std::tuple<Field<T, Ms>...>& fields() const { return fields_; }
+
+private:
+    size_t lookup(const char* name, size_t length) const {
+        uint32_t hash = detail::fnv1a_loop(name, length);
+        for (size_t s = hash & mask_; slots_[s] != 0; s = (s + 1) & mask_) {
+            const Key& key = keys_[slots_[s] - 1];
+            if (key.hash() == hash and key.equals(name, length)) {
+                return slots_[s] - 1;
+            }
+        }
+        return FIELD_COUNT;
+    }
+
+    template<size_t I>
+    detail::enable_if_t<(I < FIELD_COUNT), bool> decode_at(size_t i, const ValueRef& value, T& out) const {
+        if (i == I) {
+            return detail::Codec<typename std::tuple_element<I, std::tuple<Ms...>>::type>::decode(
+                value, out.*(std::get<I>(fields_).member));
+        }
+        return decode_at<I + 1>(i, value, out);
+    }
+
+    template<size_t I>
+    detail::enable_if_t<(I == FIELD_COUNT), bool> decode_at(size_t, const ValueRef&, T&) const {
+        return false;
+    }
+
+    template<size_t I, typename Writer>
+    detail::enable_if_t<(I < FIELD_COUNT), bool> encode_from(const T& in, Writer& writer) const {
+        const auto& f = std::get<I>(fields_);
+        return writer.Key(f.key.data(), static_cast<rapidjson::SizeType>(f.key.size())) and
+            detail::Codec<typename std::tuple_element<I, std::tuple<Ms...>>::type>::encode(writer, in.*(f.member)) and
+            encode_from<I + 1>(in, writer);
+    }
+
+    template<size_t I, typename Writer>
+    detail::enable_if_t<(I == FIELD_COUNT), bool> encode_from(const T&, Writer&) const {
+        return true;
+    }
+
+    std::tuple<Field<T, Ms>...> fields_;
+    std::vector<Key>            keys_;
+    std::vector<bool>           required_;
+    std::vector<size_t>         slots_;     // field index + 1, 0 is empty
+    size_t                      mask_;
+};
+
+template<typename T, typename... Ms>
+inline Binding<T, Ms...> make_binding(const Field<T, Ms>&... fields) {
+    return Binding<T, Ms...>(fields...);
+}
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_BINDING_H_
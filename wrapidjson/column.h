@@ -0,0 +1,83 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_COLUMN_H_
+#define WRAPIDJSON_COLUMN_H_
+
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include "key.h"
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Output column of ArrayRef::get_columns ( one member of every row object )
+///  - required : row without member ( or null member ) fails decode
+///  - optional : row without member appends T()
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+struct Column {
+    Key             key;
+    std::vector<T>* out;
+    bool            required;
+};
+
+template<size_t N, typename T>
+inline Column<T> column(const char (&name)[N], std::vector<T>& out, bool required = true) {
+    return Column<T>{Key(name), &out, required};
+}
+
+template<typename T>
+inline Column<T> column(const Key& key, std::vector<T>& out, bool required = true) {
+    return Column<T>{key, &out, required};
+}
+
+namespace detail {
+
+/// member value of key, try hint position first ( rows usually share member order )
+inline rapidjson::Value* find_member_hint(rapidjson::Value& object, const Key& key, size_t& hint) {
+    const size_t count = object.MemberCount();
+    if (count == 0) {
+        return nullptr;
+    }
+    rapidjson::Value::Member* members = &*object.MemberBegin();
+    if (hint < count) {
+        const rapidjson::Value& name = members[hint].name;
+        if (key.equals(name.GetString(), name.GetStringLength())) {
+            return &members[hint].value;
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const rapidjson::Value& name = members[i].name;
+        if (key.equals(name.GetString(), name.GetStringLength())) {
+            hint = i;
+            return &members[i].value;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_COLUMN_H_
@@ -0,0 +1,108 @@
+#ifndef WRAPIDJSON_CONTAINER_H_
+#define WRAPIDJSON_CONTAINER_H_
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include <rapidjson/document.h>
+
+#include "element.h"
+#include "type_traits.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// MemberReserve when rapidjson has it ( not in 1.1.0 ), otherwise AddMember grows as usual
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename V, typename Allocator>
+inline auto member_reserve(V& object, rapidjson::SizeType n, Allocator& alloc, int)
+    -> decltype(object.MemberReserve(n, alloc), void())
+{
+    object.MemberReserve(n, alloc);
+}
+
+template<typename V, typename Allocator>
+inline void member_reserve(V&, rapidjson::SizeType, Allocator&, long) {}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Container encoding for set_container
+///  - assign(out, v, alloc, str_copy) : write v into out, nested containers recurse
+/// arrays are reserved up front and every element is built in place in the target
+/// allocator, str_copy=false keeps references to keys and strings at every level
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T, typename Enable = void>
+struct container_value;
+
+/// bool and numbers ( same rules as bulk array paths )
+template<typename T>
+struct container_value<T, enable_if_t<is_bulk_element<T>::value>> {
+    template<typename Allocator>
+    static void assign(rapidjson::Value& out, const T& v, Allocator&, bool) {
+        out = element<T>::make(v);
+    }
+};
+
+/// other arithmetic types ( char, wchar_t, char16_t ... ) are numbers as in rapidjson::Value(v)
+template<typename T>
+struct container_value<T, enable_if_t<std::is_arithmetic<T>::value && !is_bulk_element<T>::value>> {
+    typedef typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type number_type;
+
+    template<typename Allocator>
+    static void assign(rapidjson::Value& out, const T& v, Allocator&, bool) {
+        out = rapidjson::Value(static_cast<number_type>(v));
+    }
+};
+
+template<typename T>
+struct container_value<T, enable_if_t<is_string<T>::value || is_string_view<T>::value>> {
+    template<typename Allocator>
+    static void assign(rapidjson::Value& out, const T& v, Allocator& alloc, bool str_copy) {
+        auto length = static_cast<rapidjson::SizeType>(v.length());
+        if ( str_copy ) {
+            out.SetString(v.data(), length, alloc);     // string copy
+        } else {
+            out.SetString(v.data(), length);            // string not copy
+        }
+    }
+};
+
+/// Container<T> -> Array
+template<typename T>
+struct container_value<T, enable_if_t<is_array_container<T>::value>> {
+    typedef container_value<typename T::value_type> item_type;
+
+    template<typename Allocator>
+    static void assign(rapidjson::Value& out, const T& array, Allocator& alloc, bool str_copy) {
+        out.SetArray();
+        out.Reserve(static_cast<rapidjson::SizeType>(array.size()), alloc);
+        for (const auto& k : array) {
+            out.PushBack(rapidjson::Value(), alloc);  // no reallocation after Reserve
+            item_type::assign(*(out.End() - 1), k, alloc, str_copy);
+        }
+    }
+};
+
+/// map<string, T> -> Object
+template<typename T>
+struct container_value<T, enable_if_t<is_string_map<T>::value>> {
+    typedef container_value<typename T::mapped_type> item_type;
+
+    template<typename Allocator>
+    static void assign(rapidjson::Value& out, const T& map, Allocator& alloc, bool str_copy) {
+        out.SetObject();
+        member_reserve(out, static_cast<rapidjson::SizeType>(map.size()), alloc, 0);
+        for (const auto& k : map) {
+            rapidjson::Value name;
+            container_value<std::string>::assign(name, k.first, alloc, str_copy);
+            out.AddMember(name.Move(), rapidjson::Value(), alloc);
+            item_type::assign((out.MemberEnd() - 1)->value, k.second, alloc, str_copy);
+        }
+    }
+};
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_CONTAINER_H_
@@ -24,20 +24,33 @@
 #define WRAPIDJSON_DOCUMENT_H_
 
 #include <string>
+#include <vector>
+#include <memory>
+
+#include "simd.h"
 
 #include <rapidjson/document.h>
 
+#include "error.h"
 #include "value_ref.h"
+#include "arena.h"
+#include "stream.h"
 
 namespace wrapidjson {
 
 class DocumentWrapper
 {
 public:
-    DocumentWrapper() : document_(std::make_shared<rapidjson::Document>()) {}
+    DocumentWrapper() : document_(std::make_shared<rapidjson::Document>()), arena_(nullptr) {}
+    explicit DocumentWrapper(Arena& arena)
+        : document_(std::make_shared<rapidjson::Document>(&arena.get_allocator())), arena_(&arena) {}
     virtual ~DocumentWrapper() = default;
 protected:
     std::shared_ptr<rapidjson::Document> document_;
+    std::shared_ptr<void>                buffer_;       // in-situ source owned by document
+    std::vector<std::shared_ptr<void>>   grafts_;       // storage of grafted Documents
+    Arena*                               arena_;        // caller supplied arena ( or nullptr )
+    LoadError                            load_error_;   // last load_from_*
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -50,23 +63,105 @@ public:
     explicit Document(const std::string&);
     explicit Document(const ValueRef&);
 
+    /// use caller supplied arena instead of own allocator ( arena must outlive Document )
+    explicit Document(Arena& arena);
+
     ~Document() override = default;
 
+    /// move : O(1), takes rapidjson document, in-situ buffer, grafts and arena of other.
+    /// other is left as empty Null Document with own allocator.
+    Document(Document&& other);
+    Document& operator=(Document&& other);
+
+    /// no implicit deep copy, use clone() or Document(const ValueRef&)
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    /// deep copy into new Document
+    Document clone() const;
+
+    /// exchange whole Documents, O(1)
+    void swap(Document& other);
+    using ValueRef::swap;
+
+    /// move source's root into target ( a value of this Document ) without copying.
+    ///  - shared allocator ( same Arena ) : moves the value, keeps source's in-situ buffer
+    ///  - otherwise : takes over source's storage, released on reset(), next successful load
+    ///                or destruction
+    ///  - target is root : same as operator=(Document&&)
+    /// source is left as empty Null Document.
+    void graft(const ValueRef& target, Document&& source);
+    /// number of storages kept alive for grafted values
+    size_t graft_count() const { return grafts_.size(); }
+
     /// load JSON data
+    ///  - Flags : rapidjson::ParseFlag per call site, e.g.
+    ///            load_from_buffer<rapidjson::kParseNumbersAsStringsFlag>(buffer)
+    ///            load_from_stream<rapidjson::kParseStopWhenDoneFlag>(framed)
+    ///  - kParseInsituFlag is rejected at compile time, use load_from_buffer_insitu
+    template<unsigned Flags = rapidjson::kParseDefaultFlags>
     bool load_from_file(const std::string& path);
+    template<unsigned Flags = rapidjson::kParseDefaultFlags>
     bool load_from_buffer(const std::string& buffer);
-    bool load_from_stream(std::istream& is);
+    template<unsigned Flags = rapidjson::kParseDefaultFlags>
+    bool load_from_buffer(const char* buffer);
+    template<unsigned Flags = rapidjson::kParseDefaultFlags>
+    bool load_from_buffer(const string_view& buffer);
+    template<unsigned Flags = rapidjson::kParseDefaultFlags>
+    bool load_from_stream(std::istream& is, size_t buffer_size = IStream::DEFAULT_BUFFER_SIZE);
+
+    /// load JSON data in-situ ( strings are not copied, buffer is modified )
+    ///  - std::string&& : buffer is moved into Document and lives until next load
+    ///  - char*         : buffer is owned by caller, must outlive Document's values
+    template<unsigned Flags = rapidjson::kParseDefaultFlags>
+    bool load_from_buffer_insitu(std::string&& buffer);
+    template<unsigned Flags = rapidjson::kParseDefaultFlags>
+    bool load_from_buffer_insitu(char* buffer);
+
+    /// load JSON data from memory mapped file ( falls back to load_from_file without mmap )
+    ///  - insitu : parse in place on private copy-on-write mapping, mapping lives until next successful load
+    template<unsigned Flags = rapidjson::kParseDefaultFlags>
+    bool load_from_mmap(const std::string& path, bool insitu = false);
+
+    /// load MessagePack data ( binary for wrapidjson to wrapidjson hops, no number formatting )
+    bool load_from_msgpack(const string_view& buffer);
+
+    /// code and offset of last load ( allocation free, line / column on demand )
+    const LoadError& load_error() const { return load_error_; }
+    /// formatted load_error()
     std::string get_load_error();
 
     /// save JSON data
     bool save_to_file(const std::string& path, bool pretty = false);
+    /// buffer size, atomic rename, sync and O_DIRECT policy ( see SaveOptions )
+    bool save_to_file(const std::string& path, const SaveOptions& options);
     bool save_to_buffer(std::string& buffer, bool pretty = false);
-    bool save_to_stream(std::ostream& os, bool pretty = false);
+    /// append to caller buffer, reserve it once and reuse across messages
+    bool append_to_buffer(std::string& buffer, bool pretty = false);
+    bool save_to_buffer(rapidjson::StringBuffer& buffer, bool pretty = false);
+    bool save_to_stream(std::ostream& os, bool pretty = false, size_t buffer_size = OStream::DEFAULT_BUFFER_SIZE);
+
+    /// save MessagePack data ( save replaces buffer, append keeps its contents )
+    bool save_to_msgpack(std::string& buffer);
+    bool append_to_msgpack(std::string& buffer);
+
+    /// set to Null and release memory for next message.
+    /// arena backed Document keeps arena's block, so next load does not malloc.
+    /// every ValueRef, ArrayRef, ObjectRef of this Document is invalidated.
+    void reset();
 
     /// get the actual rapidjson::Document by reference
     inline rapidjson::Document& get_document() {
         return *document_;
     }
+
+private:
+    /// record result of rapidjson parse for get_load_error,
+    /// storage ( strings of new root point into it ) replaces buffer_ only on success
+    bool loaded(detail::stats::ParseScope& stats, size_t bytes,
+            std::shared_ptr<void> storage = std::shared_ptr<void>());
+    /// keep source's in-situ buffer and grafts alive with this Document
+    void adopt_storage(Document& source);
 };
 
 } // namespace wrapidjson
@@ -2,67 +2,22 @@
 #include <memory>
 #include <iostream>
 #include <fstream>
+#include <cerrno>
 #include <cstdio>
+#include <cstring>
 
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/filereadstream.h>
-#include <rapidjson/filewritestream.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/error/en.h>
 #include <rapidjson/error/error.h>
 
-namespace wrapidjson {
+#include "mapped_file.h"
+#include "msgpack.h"
+#include "stats.h"
 
-/////////////////////////////////////////////////////////////////////////////////////////////
-/// std::istream wrapper
-/////////////////////////////////////////////////////////////////////////////////////////////
-class IStream {
-public:
-    using Ch = char;
-    IStream(std::istream& is) : is_(is) { }
-    IStream(const IStream&) = delete;
-    IStream& operator=(const IStream&) = delete;
-
-    Ch Peek() const {
-        int c = is_.peek();
-        return c == std::char_traits<Ch>::eof() ? '\0' : static_cast<Ch>(c);
-    }
-    Ch Take() {
-        int c = is_.get();
-        return c == std::char_traits<Ch>::eof() ? '\0' : static_cast<Ch>(c);
-    }
-    size_t Tell() const { return static_cast<size_t>(is_.tellg()); }
-
-    Ch* PutBegin() { throw std::runtime_error("IStream::PutBegin not implement"); }
-    void Put(Ch) { throw std::runtime_error("IStream::Put not implement"); }
-    void Flush() { throw std::runtime_error("IStream::Flush not implement"); }
-    size_t PutEnd(Ch*) { throw std::runtime_error("IStream::PutEnd not implement"); }
-private:
-    std::istream& is_;
-};
-
-/////////////////////////////////////////////////////////////////////////////////////////////
-/// std::ostream wrapper
-/////////////////////////////////////////////////////////////////////////////////////////////
-class OStream {
-public:
-    using Ch = char;
-    OStream(std::ostream& os) : os_(os) {}
-    OStream(const OStream&) = delete;
-    OStream& operator=(const OStream&) = delete;
-
-    Ch Peek() const { throw std::runtime_error("OStream::Peek not implement"); }
-    Ch Take() { throw std::runtime_error("OStream::Take not implement"); }
-    size_t Tell() const { throw std::runtime_error("OStream::Tell not implement"); }
-    Ch* PutBegin() { throw std::runtime_error("OStream::PutBegin not implement"); }
-    void Put(Ch c) { os_.put(c); }
-    void Flush() { os_.flush(); }
-    size_t PutEnd(Ch*) { throw std::runtime_error("OStream::PutEnd not implement"); }
-
-private:
-    std::ostream& os_;
-};
+namespace wrapidjson {
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// ValueRef::ValueRef(const Documnet&)
@@ -73,19 +28,11 @@ inline ValueRef::ValueRef(const Document& doc)
 
 inline ValueRef& ValueRef::operator=(const Document& doc)
 {
-    value_.CopyFrom(doc.value_, alloc_); // copy value explicitly
+    value_->CopyFrom(*doc.value_, *alloc_); // copy value explicitly
+    detail::stats::deep_copy();
     return *this;
 }
 
-inline std::string ValueRef::to_string()
-{
-    Document doc(*this);
-    std::string str;
-    doc.save_to_buffer(str);
-    return str;
-}
-
-
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// Document::Document
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -98,92 +45,241 @@ inline Document::Document(const ValueRef& other)
     : DocumentWrapper()
     , ValueRef(*document_, document_->GetAllocator())
 {
-    value_.CopyFrom(other.get_rvalue(), alloc_); // copy value explicitly
+    value_->CopyFrom(other.get_rvalue(), *alloc_); // copy value explicitly
+    detail::stats::deep_copy();
 }
 
+inline Document::Document(Arena& arena)
+    : DocumentWrapper(arena)
+    , ValueRef(*document_, document_->GetAllocator())
+{}
+
 inline Document::Document(const std::string& buffer)
     : Document()
 {
     load_from_buffer(buffer);
 }
 
+inline Document::Document(Document&& other)
+    : Document()
+{
+    swap(other);
+}
+
+inline Document& Document::operator=(Document&& other) {
+    if (this != &other) {
+        Document temp(std::move(other));
+        swap(temp);     // old contents are released with temp
+    }
+    return *this;
+}
+
+inline Document Document::clone() const {
+    return Document(static_cast<const ValueRef&>(*this));
+}
+
+/// document_ is on heap, swap owners and rebind ValueRef base to it
+inline void Document::swap(Document& other) {
+    std::swap(document_, other.document_);
+    std::swap(buffer_, other.buffer_);
+    std::swap(grafts_, other.grafts_);
+    std::swap(arena_, other.arena_);
+    std::swap(load_error_, other.load_error_);
+    value_ = document_.get();
+    alloc_ = &document_->GetAllocator();
+    other.value_ = other.document_.get();
+    other.alloc_ = &other.document_->GetAllocator();
+}
+
+inline void Document::graft(const ValueRef& target, Document&& source) {
+    if (&target.get_rvalue() == document_.get()) {
+        *this = std::move(source);
+        return;
+    }
+    if (target.shares_allocator(source)) {
+        // same arena : values move, but in-situ strings still point into source's buffer
+        ValueRef(target).move_from(source);
+        adopt_storage(source);
+        return;
+    }
+    // source's values stay in source's allocator, keep its storage alive
+    Document donor(std::move(source));
+    target.get_rvalue() = donor.get_rvalue();   // rapidjson assignment moves, no copy
+    grafts_.push_back(donor.document_);
+    adopt_storage(donor);
+}
+
+inline void Document::adopt_storage(Document& source) {
+    if (source.buffer_) {
+        grafts_.push_back(std::move(source.buffer_));
+    }
+    grafts_.insert(grafts_.end(), source.grafts_.begin(), source.grafts_.end());
+    source.buffer_.reset();
+    source.grafts_.clear();
+}
+
+namespace detail {
+
+/// parse flags of load APIs on const buffers ( in-situ needs mutable buffer )
+template<unsigned Flags>
+struct load_flags {
+    static_assert((Flags & rapidjson::kParseInsituFlag) == 0,
+        "kParseInsituFlag needs mutable buffer, use load_from_buffer_insitu or load_from_mmap(path, true)");
+    static const unsigned value = Flags;
+};
+
+} // namespace detail
+
 /// load JSON data
+template<unsigned Flags>
 inline bool Document::load_from_file(const std::string& path) {
     FILE* fp = fopen(path.c_str(), "r");
     if (fp == nullptr) {
+        load_error_.set_io_error(errno);
         return false;
     }
 
     char    readBuffer[BUFFER_SIZE];
     rapidjson::FileReadStream is(fp, readBuffer, BUFFER_SIZE);
-    document_->ParseStream(is);
+    detail::stats::ParseScope stats;
+    document_->ParseStream<detail::load_flags<Flags>::value>(is);
     fclose(fp);
-    return not document_->HasParseError();
+    return loaded(stats, is.Tell());
 }
 
+template<unsigned Flags>
 inline bool Document::load_from_buffer(const std::string& buffer) {
-    document_->Parse<0>(buffer.c_str());
-    return not document_->HasParseError();
+    detail::stats::ParseScope stats;
+    document_->Parse<detail::load_flags<Flags>::value>(buffer.c_str());
+    return loaded(stats, buffer.size());
 }
-inline bool Document::load_from_stream(std::istream& is) {
-    IStream is_wrapper(is);
-    document_->ParseStream(is_wrapper);
-    return not document_->HasParseError();
+
+template<unsigned Flags>
+inline bool Document::load_from_buffer(const char* buffer) {
+    detail::stats::ParseScope stats;
+    document_->Parse<detail::load_flags<Flags>::value>(buffer);
+    return loaded(stats, strlen(buffer));
 }
 
-inline std::string Document::get_load_error() {
-    return detail::format("Error offset[%u]: %s",
-            (unsigned)document_->GetErrorOffset(),
-            rapidjson::GetParseError_En(document_->GetParseError()));
+template<unsigned Flags>
+inline bool Document::load_from_buffer(const string_view& buffer) {
+    detail::stats::ParseScope stats;
+    document_->Parse<detail::load_flags<Flags>::value>(buffer.data(), buffer.size());
+    return loaded(stats, buffer.size());
 }
 
-/// save JSON data
-inline bool Document::save_to_file(const std::string& path, bool pretty) {
-    FILE* fp = fopen(path.c_str(), "w");
-    if (fp == nullptr) {
-        return false;
-    }
+template<unsigned Flags>
+inline bool Document::load_from_buffer_insitu(std::string&& buffer) {
+    // keep the string on heap, so that moving Document never moves string data
+    auto source = std::make_shared<std::string>(std::move(buffer));
+    detail::stats::ParseScope stats;
+    document_->ParseInsitu<Flags>(&(*source)[0]);
+    return loaded(stats, source->size(), source);
+}
 
-    char writeBuffer[BUFFER_SIZE];
-    rapidjson::FileWriteStream os(fp, writeBuffer, BUFFER_SIZE);
+template<unsigned Flags>
+inline bool Document::load_from_buffer_insitu(char* buffer) {
+    size_t size = strlen(buffer);
+    detail::stats::ParseScope stats;
+    document_->ParseInsitu<Flags>(buffer);
+    return loaded(stats, size);
+}
 
-    bool ret = false;
-    if (pretty) {
-        rapidjson::PrettyWriter<rapidjson::FileWriteStream> writer(os);
-        ret = document_->Accept(writer);
-    } else{
-        rapidjson::Writer<rapidjson::FileWriteStream> writer(os);
-        ret = document_->Accept(writer);
+template<unsigned Flags>
+inline bool Document::load_from_mmap(const std::string& path, bool insitu) {
+    auto file = std::make_shared<detail::MappedFile>();
+    if (not file->open(path, insitu)) {
+        return load_from_file<Flags>(path);
     }
-    fclose(fp);
-    return ret;
+    detail::stats::ParseScope stats;
+    if (insitu) {
+        document_->ParseInsitu<detail::load_flags<Flags>::value>(file->data());
+        return loaded(stats, file->size(), file);   // strings point into mapping
+    }
+    document_->Parse<detail::load_flags<Flags>::value>(file->data(), file->size());
+    return loaded(stats, file->size());
 }
 
-inline bool Document::save_to_buffer(std::string& buffer, bool pretty) {
-    rapidjson::StringBuffer stringBuf;
-    bool ret = false;
-    if (pretty){
-        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(stringBuf);
-        ret = document_->Accept(writer);
-    } else {
-        rapidjson::Writer<rapidjson::StringBuffer> writer(stringBuf);
-        ret = document_->Accept(writer);
-    }
-    if ( ret ) {
-        buffer.assign(stringBuf.GetString(), stringBuf.GetSize());
+template<unsigned Flags>
+inline bool Document::load_from_stream(std::istream& is, size_t buffer_size) {
+    IStream is_wrapper(is, buffer_size);
+    detail::stats::ParseScope stats;
+    document_->ParseStream<detail::load_flags<Flags>::value>(is_wrapper);
+    return loaded(stats, is_wrapper.Tell());
+}
+
+/// rapidjson keeps the old root when parse fails, so old storage is released only on success
+inline bool Document::loaded(detail::stats::ParseScope& stats, size_t bytes, std::shared_ptr<void> storage) {
+    load_error_.set(document_->GetParseError(), document_->GetErrorOffset());
+    if (load_error_.ok()) {
+        buffer_ = std::move(storage);
+        grafts_.clear();    // old root and values grafted into it are gone
     }
-    return ret;
+    return stats.done(*document_, bytes);
+}
+
+/// load MessagePack data ( SAX events into rapidjson::Document, strings are copied )
+inline bool Document::load_from_msgpack(const string_view& buffer) {
+    detail::stats::ParseScope stats;
+    detail::msgpack::Decoder decoder(buffer.data(), buffer.size());
+    document_->SetNull();
+    document_->Populate(decoder);   // Document is null on failure ( root was cleared above )
+    buffer_.reset();
+    grafts_.clear();
+    load_error_.set(decoder.result().Code(), decoder.result().Offset());
+    return stats.done(*document_, buffer.size(), load_error_.ok());
+}
+
+inline std::string Document::get_load_error() {
+    return load_error_.to_string();
 }
 
-inline bool Document::save_to_stream(std::ostream& os, bool pretty) {
-    OStream os_wrapper(os);
-    if (pretty) {
-        rapidjson::PrettyWriter<OStream> writer(os_wrapper);
-        return document_->Accept(writer);
+inline void Document::reset() {
+    document_->SetNull();
+    buffer_.reset();
+    grafts_.clear();
+    if (arena_ != nullptr) {
+        arena_->reset();
     } else {
-        rapidjson::Writer<OStream> writer(os_wrapper);
-        return document_->Accept(writer);
+        document_->GetAllocator().Clear();
     }
 }
 
+/// save JSON data
+inline bool Document::save_to_file(const std::string& path, bool pretty) {
+    return detail::write_value_to_file(*document_, path, pretty);
+}
+
+inline bool Document::save_to_file(const std::string& path, const SaveOptions& options) {
+    return detail::write_value_to_file(*document_, path, options);
+}
+
+inline bool Document::save_to_buffer(std::string& buffer, bool pretty) {
+    return detail::write_value(*document_, buffer, pretty);
+}
+
+inline bool Document::append_to_buffer(std::string& buffer, bool pretty) {
+    return detail::append_value(*document_, buffer, pretty);
+}
+
+inline bool Document::save_to_buffer(rapidjson::StringBuffer& buffer, bool pretty) {
+    return detail::write_value(*document_, buffer, pretty);
+}
+
+inline bool Document::save_to_msgpack(std::string& buffer) {
+    buffer.clear();
+    return append_to_msgpack(buffer);
+}
+
+inline bool Document::append_to_msgpack(std::string& buffer) {
+    detail::stats::SerializeScope stats;
+    size_t size = buffer.size();
+    detail::msgpack::Encoder(buffer).encode(*document_);
+    return stats.done(buffer.size() - size, true);
+}
+
+inline bool Document::save_to_stream(std::ostream& os, bool pretty, size_t buffer_size) {
+    return detail::write_value(*document_, os, pretty, buffer_size);
+}
+
 } // namespace wrapidjson
@@ -0,0 +1,85 @@
+#ifndef WRAPIDJSON_ELEMENT_H_
+#define WRAPIDJSON_ELEMENT_H_
+
+#include <cstdint>
+#include <limits>
+
+#include <rapidjson/document.h>
+
+#include "type_traits.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Element type traits for bulk array paths ( same rules as ValueRef::get<T> )
+///  - is(value)   : value converts to T
+///  - get(value)  : convert, is(value) must be true
+///  - make(v)     : rapidjson::Value of v
+/// bulk is false for types handled element by element through ValueRef
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T, typename Enable = void>
+struct element {
+    static const bool bulk = false;
+};
+
+template<typename T>
+struct element<T, void_t<enable_if_bool_t<T>>> {
+    static const bool bulk = true;
+    static bool is(const rapidjson::Value& v) { return v.IsBool(); }
+    static T get(const rapidjson::Value& v) { return v.GetBool(); }
+    static rapidjson::Value make(T v) { return rapidjson::Value(v); }
+};
+
+template<typename T>
+struct element<T, void_t<enable_if_int_t<T>>> {
+    static const bool bulk = true;
+    static bool is(const rapidjson::Value& v) {
+        return v.IsInt() and v.GetInt() >= std::numeric_limits<T>::min() and
+            v.GetInt() <= std::numeric_limits<T>::max();
+    }
+    static T get(const rapidjson::Value& v) { return static_cast<T>(v.GetInt()); }
+    static rapidjson::Value make(T v) { return rapidjson::Value(static_cast<int>(v)); }
+};
+
+template<typename T>
+struct element<T, void_t<enable_if_int64_t<T>>> {
+    static const bool bulk = true;
+    static bool is(const rapidjson::Value& v) { return v.IsInt64(); }
+    static T get(const rapidjson::Value& v) { return static_cast<T>(v.GetInt64()); }
+    static rapidjson::Value make(T v) { return rapidjson::Value(static_cast<int64_t>(v)); }
+};
+
+template<typename T>
+struct element<T, void_t<enable_if_uint_t<T>>> {
+    static const bool bulk = true;
+    static bool is(const rapidjson::Value& v) {
+        return v.IsUint() and v.GetUint() <= std::numeric_limits<T>::max();
+    }
+    static T get(const rapidjson::Value& v) { return static_cast<T>(v.GetUint()); }
+    static rapidjson::Value make(T v) { return rapidjson::Value(static_cast<unsigned>(v)); }
+};
+
+template<typename T>
+struct element<T, void_t<enable_if_uint64_t<T>>> {
+    static const bool bulk = true;
+    static bool is(const rapidjson::Value& v) { return v.IsUint64(); }
+    static T get(const rapidjson::Value& v) { return static_cast<T>(v.GetUint64()); }
+    static rapidjson::Value make(T v) { return rapidjson::Value(static_cast<uint64_t>(v)); }
+};
+
+template<typename T>
+struct element<T, void_t<enable_if_float_t<T>>> {
+    static const bool bulk = true;
+    static bool is(const rapidjson::Value& v) { return v.IsNumber(); }
+    static T get(const rapidjson::Value& v) { return static_cast<T>(v.GetDouble()); }
+    static rapidjson::Value make(T v) { return rapidjson::Value(static_cast<double>(v)); }
+};
+
+template<typename T>
+using is_bulk_element = std::integral_constant<bool, element<T>::bulk>;
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_ELEMENT_H_
@@ -0,0 +1,163 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_ERROR_H_
+#define WRAPIDJSON_ERROR_H_
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+#include <rapidjson/error/en.h>
+#include <rapidjson/error/error.h>
+
+#include "string_view.hpp"
+#include "optional.hpp"
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Error codes of non throwing accessors ( try_at / try_get )
+/////////////////////////////////////////////////////////////////////////////////////////////
+enum class ErrorCode { OK, NOT_ARRAY, NOT_OBJECT, OUT_OF_RANGE, NO_MEMBER, TYPE_MISMATCH };
+
+/// static message, nothing is allocated
+inline const char* error_string(ErrorCode code) {
+    switch (code) {
+    case ErrorCode::OK:             return "ok";
+    case ErrorCode::NOT_ARRAY:      return "value is not array";
+    case ErrorCode::NOT_OBJECT:     return "value is not object";
+    case ErrorCode::OUT_OF_RANGE:   return "array index out of range";
+    case ErrorCode::NO_MEMBER:      return "member not found";
+    case ErrorCode::TYPE_MISMATCH:  return "value has other type";
+    }
+    return "unknown error";
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Value or ErrorCode
+///  - checked like optional ( if (res) ... *res ), error() tells why it is empty
+///  - value() throws std::runtime_error with error_string on error
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+class Expected {
+public:
+    Expected(ErrorCode code) : code_(code) {}
+    Expected(const T& value) : code_(ErrorCode::OK), value_(value) {}
+
+    bool ok() const { return code_ == ErrorCode::OK; }
+    explicit operator bool() const { return ok(); }
+    ErrorCode error() const { return code_; }
+
+    const T& value() const {
+        if (not ok()) {
+            throw std::runtime_error(error_string(code_));
+        }
+        return *value_;
+    }
+    T value_or(const T& other) const { return ok() ? *value_ : other; }
+
+    const T& operator*() const { return *value_; }
+    const T* operator->() const { return &*value_; }
+
+private:
+    ErrorCode           code_;
+    nonstd::optional<T> value_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Result of last load ( code and byte offset, nothing is formatted or allocated )
+///  - line / column are counted on demand from the source that was loaded
+///  - write formats "Error offset[..]: message" into caller buffer
+///  - io_error : errno when the source could not be opened ( code() is kParseErrorNone )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class LoadError {
+public:
+    LoadError() : code_(rapidjson::kParseErrorNone), offset_(0), io_error_(0) {}
+    LoadError(rapidjson::ParseErrorCode code, size_t offset) : code_(code), offset_(offset), io_error_(0) {}
+
+    bool ok() const { return code_ == rapidjson::kParseErrorNone and io_error_ == 0; }
+    explicit operator bool() const { return not ok(); }    // true on error, like ParseResult::IsError
+
+    rapidjson::ParseErrorCode code() const { return code_; }
+    size_t offset() const { return offset_; }
+    int io_error() const { return io_error_; }
+    const char* message() const {
+        return io_error_ != 0 ? std::strerror(io_error_) : rapidjson::GetParseError_En(code_);
+    }
+
+    /// 1-based line and column of offset in source ( column counts bytes )
+    size_t line(const nonstd::string_view& source) const {
+        size_t end = offset_ < source.size() ? offset_ : source.size();
+        size_t line = 1;
+        for (size_t i = 0; i < end; ++i) {
+            line += (source[i] == '\n');
+        }
+        return line;
+    }
+
+    size_t column(const nonstd::string_view& source) const {
+        size_t end = offset_ < source.size() ? offset_ : source.size();
+        size_t begin = end;
+        while (begin > 0 and source[begin - 1] != '\n') {
+            --begin;
+        }
+        return end - begin + 1;
+    }
+
+    /// snprintf semantics : length of whole message, buffer is always terminated
+    int write(char* buffer, size_t size) const {
+        if (io_error_ != 0) {
+            return std::snprintf(buffer, size, "Error io[%d]: %s", io_error_, message());
+        }
+        return std::snprintf(buffer, size, "Error offset[%u]: %s", (unsigned)offset_, message());
+    }
+
+    std::string to_string() const {
+        char buffer[128];   // longest rapidjson message is well below
+        int n = write(buffer, sizeof(buffer));
+        return std::string(buffer, n < (int)sizeof(buffer) ? n : sizeof(buffer) - 1);
+    }
+
+    void set(rapidjson::ParseErrorCode code, size_t offset) {
+        code_ = code;
+        offset_ = offset;
+        io_error_ = 0;
+    }
+
+    /// source could not be opened or read ( error is errno, 0 is reported as EIO )
+    void set_io_error(int error) {
+        code_ = rapidjson::kParseErrorNone;
+        offset_ = 0;
+        io_error_ = error != 0 ? error : EIO;
+    }
+
+private:
+    rapidjson::ParseErrorCode   code_;
+    size_t                      offset_;
+    int                         io_error_;
+};
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_ERROR_H_
@@ -0,0 +1,278 @@
+#ifndef WRAPIDJSON_FILE_WRITER_H_
+#define WRAPIDJSON_FILE_WRITER_H_
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define WRAPIDJSON_HAS_POSIX_IO 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#else
+#define WRAPIDJSON_HAS_POSIX_IO 0
+#endif
+
+#include <rapidjson/document.h>
+#include <rapidjson/filewritestream.h>
+
+#include "writer.h"
+
+namespace wrapidjson {
+
+/// durability of save_to_file ( before close, and rename in atomic mode )
+enum class SyncPolicy {
+    NONE,       // leave it to page cache
+    DATASYNC,   // fdatasync, file data and size
+    FSYNC,      // fsync, data and all metadata
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Options of save_to_file / write_to_file
+///  - buffer_size : output block, one write(2) per block
+///  - atomic      : write "path.tmp.<pid>.<n>" and rename over path, readers never see half a file
+///  - sync        : SyncPolicy before close ( and directory after rename when atomic )
+///  - direct      : O_DIRECT where supported, blocks bypass page cache for large dumps
+///                  ( buffer is rounded up to DIRECT_ALIGNMENT, falls back to buffered io )
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct SaveOptions {
+    static const size_t DEFAULT_BUFFER_SIZE = 65536;
+    static const size_t DIRECT_ALIGNMENT = 4096;
+
+    bool        pretty = false;
+    size_t      buffer_size = DEFAULT_BUFFER_SIZE;
+    bool        atomic = false;
+    SyncPolicy  sync = SyncPolicy::NONE;
+    bool        direct = false;
+};
+
+namespace detail {
+
+#if WRAPIDJSON_HAS_POSIX_IO
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// rapidjson output stream on file descriptor
+///  - heap block of buffer_size, written when full and by finish()
+///  - direct : only whole aligned blocks go out while writing, the tail is written by
+///             finish() after O_DIRECT is cleared
+/////////////////////////////////////////////////////////////////////////////////////////////
+class FileOStream {
+public:
+    using Ch = char;
+
+    FileOStream(int fd, size_t buffer_size, bool direct)
+        : fd_(fd), direct_(direct), good_(true)
+        , buffer_size_(aligned_size(buffer_size, direct))
+        , buffer_(allocate(buffer_size_, direct), &std::free)
+        , current_(buffer_.get())
+        , end_(buffer_.get() + buffer_size_)
+    {
+        if (not buffer_) {
+            good_ = false;
+            end_ = current_;
+        }
+    }
+    FileOStream(const FileOStream&) = delete;
+    FileOStream& operator=(const FileOStream&) = delete;
+
+    void Put(Ch c) {
+        if (current_ == end_) {
+            write_block();
+            if (current_ == end_) {
+                return;     // failed, drop output ( finish() reports it )
+            }
+        }
+        *current_++ = c;
+    }
+    /// Writer flushes at end of document, direct io keeps the tail for finish()
+    void Flush() {
+        if (not direct_) {
+            write_block();
+        }
+    }
+
+    /// write remaining output, false when any write failed
+    bool finish() {
+        if (direct_ and current_ != buffer_.get()) {
+            clear_direct();
+        }
+        write_block();
+        return good_;
+    }
+
+private:
+    static size_t aligned_size(size_t size, bool direct) {
+        size_t align = direct ? SaveOptions::DIRECT_ALIGNMENT : 1;
+        size = size > 0 ? size : 1;
+        return (size + align - 1) / align * align;
+    }
+
+    static Ch* allocate(size_t size, bool direct) {
+        void* buffer = nullptr;
+        if (direct) {
+            if (::posix_memalign(&buffer, SaveOptions::DIRECT_ALIGNMENT, size) != 0) {
+                return nullptr;
+            }
+        } else {
+            buffer = std::malloc(size);
+        }
+        return static_cast<Ch*>(buffer);
+    }
+
+    void clear_direct() {
+#ifdef O_DIRECT
+        int flags = ::fcntl(fd_, F_GETFL);
+        if (flags >= 0) {
+            ::fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+        }
+#endif
+        direct_ = false;
+    }
+
+    void write_block() {
+        const Ch* data = buffer_.get();
+        size_t size = static_cast<size_t>(current_ - data);
+        while (good_ and size > 0) {
+            ssize_t n = ::write(fd_, data, size);
+            if (n > 0) {
+                data += n;
+                size -= static_cast<size_t>(n);
+            } else if (n < 0 and errno == EINTR) {
+                continue;
+            } else if (n < 0 and errno == EINVAL and direct_) {
+                clear_direct();     // filesystem accepted O_DIRECT on open but not the write
+            } else {
+                good_ = false;
+            }
+        }
+        current_ = buffer_.get();
+    }
+
+    int                                         fd_;
+    bool                                        direct_;
+    bool                                        good_;
+    size_t                                      buffer_size_;
+    std::unique_ptr<Ch, decltype(&std::free)>   buffer_;
+    Ch*                                         current_;
+    Ch*                                         end_;
+};
+
+/// O_DIRECT when asked and accepted ( tmpfs rejects it ), direct tells what was opened
+inline int open_for_write(const std::string& path, bool& direct) {
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+#ifdef O_DIRECT
+    if (direct) {
+        int fd = ::open(path.c_str(), flags | O_DIRECT, 0666);
+        if (fd >= 0) {
+            return fd;
+        }
+    }
+#endif
+    direct = false;
+    return ::open(path.c_str(), flags, 0666);
+}
+
+inline bool sync_fd(int fd, SyncPolicy sync) {
+    switch (sync) {
+    case SyncPolicy::NONE:
+        return true;
+    case SyncPolicy::DATASYNC:
+#if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+        return ::fdatasync(fd) == 0;
+#else
+        return ::fsync(fd) == 0;
+#endif
+    case SyncPolicy::FSYNC:
+        return ::fsync(fd) == 0;
+    }
+    return false;
+}
+
+/// make rename durable, best effort ( some filesystems refuse fsync on directory )
+inline void sync_parent_directory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+/// unique sibling of path, so that concurrent saves never share a temp file
+inline std::string temp_path(const std::string& path) {
+    static std::atomic<unsigned> sequence(0);
+    return path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(sequence.fetch_add(1));
+}
+
+inline bool write_value_to_file(const rapidjson::Value& value, const std::string& path,
+        const SaveOptions& options) {
+    std::string target = options.atomic ? temp_path(path) : path;
+    bool direct = options.direct;
+    int fd = open_for_write(target, direct);
+    if (fd < 0) {
+        return false;
+    }
+
+    FileOStream os(fd, options.buffer_size, direct);
+    bool ret = write_stream(value, os, options.pretty);
+    ret = os.finish() and ret;
+    ret = ret and sync_fd(fd, options.sync);
+    ret = (::close(fd) == 0) and ret;
+
+    if (options.atomic) {
+        if (ret and ::rename(target.c_str(), path.c_str()) == 0) {
+            if (options.sync != SyncPolicy::NONE) {
+                sync_parent_directory(path);
+            }
+        } else {
+            ::unlink(target.c_str());   // path keeps its previous contents
+            ret = false;
+        }
+    }
+    return ret;
+}
+#else
+/// stdio fallback ( buffer_size and atomic rename only, sync and direct are ignored )
+inline bool write_value_to_file(const rapidjson::Value& value, const std::string& path,
+        const SaveOptions& options) {
+    std::string target = options.atomic ? path + ".tmp" : path;
+    FILE* fp = fopen(target.c_str(), "wb");
+    if (fp == nullptr) {
+        return false;
+    }
+
+    size_t buffer_size = options.buffer_size > 0 ? options.buffer_size : 1;
+    std::unique_ptr<char[]> buffer(new char[buffer_size]);
+    rapidjson::FileWriteStream os(fp, buffer.get(), buffer_size);
+    bool ret = write_stream(value, os, options.pretty);
+    os.Flush();
+    ret = (fclose(fp) == 0) and ret;
+
+    if (options.atomic) {
+        if (ret) {
+            std::remove(path.c_str());      // rename does not replace on every platform
+            ret = std::rename(target.c_str(), path.c_str()) == 0;
+        }
+        if (not ret) {
+            std::remove(target.c_str());
+        }
+    }
+    return ret;
+}
+#endif
+
+inline bool write_value_to_file(const rapidjson::Value& value, const std::string& path, bool pretty) {
+    SaveOptions options;
+    options.pretty = pretty;
+    return write_value_to_file(value, path, options);
+}
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_FILE_WRITER_H_
@@ -4,7 +4,9 @@
 #include <cstdio>
 #include <cstdlib>
 #include <string>
-#include <memory>
+#include <cmath>
+
+#include <rapidjson/writer.h>
 
 namespace wrapidjson {
 namespace detail {
@@ -17,13 +19,50 @@ namespace format_helper
 
 inline std::string format(const std::string& format) { return format; }
 
+/// one snprintf into stack buffer, heap only for messages longer than it
 template<typename ... Args>
 inline std::string format(const std::string& format, Args&& ... args)
 {
-    size_t size = std::snprintf(nullptr, 0, format.c_str(), format_helper::cast(std::forward<Args>(args))...) + 1;
-    std::unique_ptr<char[]> buffer(new char[size]);
-    std::snprintf(buffer.get(), size, format.c_str(), format_helper::cast(std::forward<Args>(args))...);
-    return std::string(buffer.get(), buffer.get() + size - 1);
+    char buffer[256];
+    int size = std::snprintf(buffer, sizeof(buffer), format.c_str(), format_helper::cast(std::forward<Args>(args))...);
+    if (size < 0) {
+        return std::string();
+    } else if (static_cast<size_t>(size) < sizeof(buffer)) {
+        return std::string(buffer, size);
+    }
+    std::string str(size, '\0');
+    std::snprintf(&str[0], size + 1, format.c_str(), format_helper::cast(std::forward<Args>(args))...);
+    return str;
+}
+
+namespace format_helper
+{
+    /// rapidjson output stream on fixed buffer
+    class FixedBuffer {
+    public:
+        using Ch = char;
+        FixedBuffer() : size_(0) {}
+        void Put(Ch c) { if (size_ < sizeof(buffer_)) { buffer_[size_++] = c; } }
+        void Flush() {}
+        std::string str() const { return std::string(buffer_, size_); }
+    private:
+        char    buffer_[32];    // longest Grisu2 output is 25 bytes
+        size_t  size_;
+    };
+};
+
+/// shortest round-trip decimal form, locale free ( "0.1", "1e30", "nan", "inf", "-inf" )
+inline std::string format_double(double value)
+{
+    if (std::isnan(value)) {
+        return "nan";
+    } else if (std::isinf(value)) {
+        return value < 0 ? "-inf" : "inf";
+    }
+    format_helper::FixedBuffer buffer;
+    rapidjson::Writer<format_helper::FixedBuffer> writer(buffer);
+    writer.Double(value);
+    return buffer.str();
 }
 
 } // namespace detail
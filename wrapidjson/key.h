@@ -0,0 +1,126 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_KEY_H_
+#define WRAPIDJSON_KEY_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "string_view.hpp"
+
+namespace wrapidjson {
+
+using string_view = nonstd::string_view;
+
+namespace detail {
+
+static const uint32_t FNV_OFFSET_BASIS = 2166136261u;
+static const uint32_t FNV_PRIME = 16777619u;
+
+/// FNV-1a, compile time ( C++11 constexpr : recursion only )
+constexpr uint32_t fnv1a(const char* s, size_t n, uint32_t h = FNV_OFFSET_BASIS) {
+    return n == 0 ? h : fnv1a(s + 1, n - 1, (h ^ static_cast<uint8_t>(*s)) * FNV_PRIME);
+}
+
+/// FNV-1a, run time
+inline uint32_t fnv1a_loop(const char* s, size_t n) {
+    uint32_t h = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < n; ++i) {
+        h = (h ^ static_cast<uint8_t>(s[i])) * FNV_PRIME;
+    }
+    return h;
+}
+
+/// FNV-1a of literal : recursion only in constant evaluation ( one frame per byte at -O0 ),
+/// loop at run time where compiler tells ( GCC 10 / Clang 9 / MSVC 19.25 )
+#if defined(__has_builtin)
+#  if __has_builtin(__builtin_is_constant_evaluated)
+#    define WRAPIDJSON_HAS_IS_CONSTANT_EVALUATED 1
+#  endif
+#endif
+#if !defined(WRAPIDJSON_HAS_IS_CONSTANT_EVALUATED) && defined(_MSC_VER) && _MSC_VER >= 1925
+#  define WRAPIDJSON_HAS_IS_CONSTANT_EVALUATED 1
+#endif
+
+constexpr uint32_t fnv1a_literal(const char* s, size_t n) {
+#if defined(WRAPIDJSON_HAS_IS_CONSTANT_EVALUATED)
+    return __builtin_is_constant_evaluated() ? fnv1a(s, n) : fnv1a_loop(s, n);
+#else
+    return fnv1a(s, n);
+#endif
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Member name handle with precomputed length and hash
+///  - build once and reuse for every lookup ( constexpr from literal )
+///  - Key does not own the string, it must outlive the Key
+///    ( inserting members with Key copies the name into Document )
+///
+///   static constexpr Key ID("id");
+///   auto id = obj[ID].as<int>();
+///   auto name = obj.find("name"_key);
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Key {
+public:
+    template<size_t N>
+    constexpr explicit Key(const char (&s)[N])
+        : data_(s), size_(N - 1), hash_(detail::fnv1a_literal(s, N - 1)) {}
+
+    /// run time keys ( hash by loop )
+    Key(const char* s, size_t n)
+        : data_(s), size_(n), hash_(detail::fnv1a_loop(s, n)) {}
+
+    explicit Key(const string_view& s)
+        : data_(s.data()), size_(s.size()), hash_(detail::fnv1a_loop(s.data(), s.size())) {}
+
+    constexpr const char* data() const { return data_; }
+    constexpr size_t size() const { return size_; }
+    constexpr uint32_t hash() const { return hash_; }
+
+    bool equals(const char* s, size_t n) const {
+        return n == size_ and (size_ == 0 or (s[0] == data_[0] and memcmp(s, data_, size_) == 0));
+    }
+
+    std::string str() const { return std::string(data_, size_); }
+    operator string_view() const { return string_view(data_, size_); }
+
+private:
+    friend constexpr Key operator"" _key(const char* s, size_t n);
+
+    constexpr Key(const char* s, size_t n, uint32_t hash) : data_(s), size_(n), hash_(hash) {}
+
+    const char* data_;
+    size_t      size_;
+    uint32_t    hash_;
+};
+
+/// "name"_key
+constexpr Key operator"" _key(const char* s, size_t n) {
+    return Key(s, n, detail::fnv1a_literal(s, n));
+}
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_KEY_H_
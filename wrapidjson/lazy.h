@@ -0,0 +1,377 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_LAZY_H_
+#define WRAPIDJSON_LAZY_H_
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <memory>
+
+#include <rapidjson/reader.h>
+#include <rapidjson/error/en.h>
+
+#include "document.h"
+#include "simd.h"
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// On demand Document ( validate once, index top level values, parse only what is used )
+///  - load validates UTF-8 ( SIMD ) and whole buffer by SAX without building DOM
+///  - top level members ( or elements ) are indexed by byte range
+///  - find / at parse only that value into its own Document, parsed once and cached
+///  - save copies untouched values byte for byte, only materialized values are serialized
+///  - root() materializes whole Document ( edits made through find / at are kept )
+///
+///   LazyDocument msg;
+///   msg.load_from_buffer(payload);
+///   auto type = msg.find("type");            // only "type" is parsed
+///   (*msg.find("hops")) = hops + 1;
+///   msg.save_to_buffer(out);                 // rest is raw copy
+/////////////////////////////////////////////////////////////////////////////////////////////
+class LazyDocument {
+public:
+    LazyDocument() : type_(rapidjson::kNullType) {}
+    LazyDocument(const LazyDocument&) = delete;
+    LazyDocument& operator=(const LazyDocument&) = delete;
+    LazyDocument(LazyDocument&&) = default;
+    LazyDocument& operator=(LazyDocument&&) = default;
+
+    /// load JSON data ( buffer is copied / moved into LazyDocument )
+    bool load_from_buffer(const string_view& buffer) {
+        return load_from_buffer(std::string(buffer.data(), buffer.size()));
+    }
+
+    bool load_from_buffer(const char* buffer) {
+        return load_from_buffer(std::string(buffer));
+    }
+
+    bool load_from_buffer(std::string&& buffer) {
+        buffer_ = std::move(buffer);
+        entries_.clear();
+        root_.reset();
+        type_ = rapidjson::kNullType;
+
+        size_t invalid = detail::simd::find_invalid_utf8(buffer_.data(), buffer_.size());
+        if (invalid != buffer_.size()) {
+            result_.Set(rapidjson::kParseErrorStringInvalidEncoding, invalid);
+            return false;
+        }
+
+        rapidjson::BaseReaderHandler<> handler;
+        rapidjson::Reader reader;
+        rapidjson::StringStream ss(buffer_.c_str());
+        result_ = reader.Parse<rapidjson::kParseNumbersAsStringsFlag>(ss, handler);
+        if (result_.IsError()) {
+            return false;
+        }
+        index();
+        return true;
+    }
+
+    LoadError load_error() const { return LoadError(result_.Code(), result_.Offset()); }
+    std::string get_load_error() const { return load_error().to_string(); }
+
+    bool is_object() const { return type_ == rapidjson::kObjectType; }
+    bool is_array() const { return type_ == rapidjson::kArrayType; }
+
+    /// top level member / element count
+    size_t size() const { return entries_.size(); }
+
+    bool has(const string_view& name) const { return lookup(name) != entries_.size(); }
+
+    /// raw JSON bytes of top level value, as in input
+    optional<string_view> raw(const string_view& name) const {
+        return raw_at(lookup(name));
+    }
+
+    optional<string_view> raw(size_t index) const {
+        return raw_at(index);
+    }
+
+    /// materialize top level member ( duplicate names : first member )
+    optional<ValueRef> find(const string_view& name) {
+        optional<ValueRef> result;
+        if (root_) {
+            if (root_->is_object()) {
+                return root_->get_object().find(name);
+            }
+            return result;
+        }
+        size_t i = lookup(name);
+        if (i != entries_.size()) {
+            result.emplace(materialize(i));
+        }
+        return result;
+    }
+
+    /// materialize top level array element
+    optional<ValueRef> at(size_t index) {
+        optional<ValueRef> result;
+        if (not is_array() or index >= entries_.size()) {
+            return result;
+        }
+        if (root_) {
+            result.emplace(root_->get_rvalue()[static_cast<rapidjson::SizeType>(index)], root_->get_document().GetAllocator());
+        } else {
+            result.emplace(materialize(index));
+        }
+        return result;
+    }
+
+    /// whole Document, parsed on first call
+    Document& root() {
+        if (not root_) {
+            root_ = std::make_shared<Document>();
+            root_->load_from_buffer(string_view(buffer_));
+            auto& alloc = root_->get_document().GetAllocator();
+            for (size_t i = 0; i < entries_.size(); ++i) {
+                const Entry& entry = entries_[i];
+                if (not entry.value) {
+                    continue;
+                }
+                rapidjson::Value* target = nullptr;
+                if (is_object()) {
+                    string_view n = name(entry);
+                    auto it = root_->get_rvalue().FindMember(
+                        rapidjson::StringRef(n.data(), static_cast<rapidjson::SizeType>(n.size())));
+                    target = &it->value;
+                } else {
+                    target = &root_->get_rvalue()[static_cast<rapidjson::SizeType>(i)];
+                }
+                target->CopyFrom(entry.value->get_rvalue(), alloc);
+            }
+        }
+        return *root_;
+    }
+
+    /// save JSON data ( untouched values are copied as is )
+    bool save_to_buffer(std::string& buffer) {
+        buffer.clear();
+        return append_to_buffer(buffer);
+    }
+
+    bool append_to_buffer(std::string& buffer) {
+        if (result_.IsError()) {
+            return false;
+        }
+        if (root_) {
+            return root_->append_to_buffer(buffer);
+        }
+        if (not is_object() and not is_array()) {
+            buffer.append(buffer_, value_begin_, value_end_ - value_begin_);
+            return true;
+        }
+        buffer.reserve(buffer.size() + buffer_.size());
+        buffer.push_back(is_object() ? '{' : '[');
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            const Entry& entry = entries_[i];
+            if (i > 0) {
+                buffer.push_back(',');
+            }
+            if (is_object()) {
+                buffer.append(buffer_, entry.key_begin, entry.key_end - entry.key_begin);
+                buffer.push_back(':');
+            }
+            if (entry.value) {
+                if (not entry.value->append_to_buffer(buffer)) {
+                    return false;
+                }
+            } else {
+                buffer.append(buffer_, entry.begin, entry.end - entry.begin);
+            }
+        }
+        buffer.push_back(is_object() ? '}' : ']');
+        return true;
+    }
+
+    std::string to_string() {
+        std::string buffer;
+        save_to_buffer(buffer);
+        return buffer;
+    }
+
+private:
+    struct Entry {
+        size_t                      key_begin;  // quoted key ( object only )
+        size_t                      key_end;
+        size_t                      begin;      // value bytes
+        size_t                      end;
+        bool                        escaped;    // key has escapes, decoded into name
+        std::string                 name;
+        std::shared_ptr<Document>   value;      // materialized value
+    };
+
+    string_view name(const Entry& entry) const {
+        if (entry.escaped) {
+            return string_view(entry.name);
+        }
+        return string_view(buffer_.data() + entry.key_begin + 1, entry.key_end - entry.key_begin - 2);
+    }
+
+    size_t lookup(const string_view& n) const {
+        if (not is_object()) {
+            return entries_.size();
+        }
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            string_view key = name(entries_[i]);
+            if (key.size() == n.size() and memcmp(key.data(), n.data(), n.size()) == 0) {
+                return i;
+            }
+        }
+        return entries_.size();
+    }
+
+    optional<string_view> raw_at(size_t i) const {
+        optional<string_view> result;
+        if (i < entries_.size()) {
+            result = string_view(buffer_.data() + entries_[i].begin, entries_[i].end - entries_[i].begin);
+        }
+        return result;
+    }
+
+    ValueRef materialize(size_t i) {
+        Entry& entry = entries_[i];
+        if (not entry.value) {
+            entry.value = std::make_shared<Document>();
+            entry.value->load_from_buffer(*raw_at(i));
+        }
+        return *entry.value;
+    }
+
+    static bool is_space(char c) {
+        return c == ' ' or c == '\t' or c == '\n' or c == '\r';
+    }
+
+    void skip_space(size_t& p) const {
+        while (p < buffer_.size() and is_space(buffer_[p])) {
+            ++p;
+        }
+    }
+
+    /// p is at opening quote, returns position after closing quote
+    size_t skip_string(size_t p, bool& escaped) const {
+        const char* data = buffer_.data();
+        const char* end = data + buffer_.size();
+        const char* q = data + p + 1;
+        while (true) {
+            q = detail::simd::find_quote_or_escape(q, end);
+            if (*q == '"') {
+                return static_cast<size_t>(q - data) + 1;
+            }
+            escaped = true;
+            q += 2;
+        }
+    }
+
+    /// returns position after value ( input is validated )
+    size_t skip_value(size_t p) const {
+        bool escaped = false;
+        char c = buffer_[p];
+        if (c == '"') {
+            return skip_string(p, escaped);
+        }
+        if (c == '{' or c == '[') {
+            const char* data = buffer_.data();
+            const char* end = data + buffer_.size();
+            size_t depth = 0;
+            do {
+                p = static_cast<size_t>(detail::simd::find_structural(data + p, end) - data);
+                c = buffer_[p];
+                if (c == '"') {
+                    p = skip_string(p, escaped);
+                    continue;
+                }
+                if (c == '{' or c == '[') {
+                    ++depth;
+                } else {
+                    --depth;
+                }
+                ++p;
+            } while (depth > 0);
+            return p;
+        }
+        while (p < buffer_.size() and not is_space(buffer_[p]) and
+                buffer_[p] != ',' and buffer_[p] != '}' and buffer_[p] != ']') {
+            ++p;
+        }
+        return p;
+    }
+
+    void index() {
+        size_t p = 0;
+        skip_space(p);
+        value_begin_ = p;
+        value_end_ = skip_value(p);
+        char c = buffer_[p];
+        if (c == '{') {
+            type_ = rapidjson::kObjectType;
+        } else if (c == '[') {
+            type_ = rapidjson::kArrayType;
+        } else {
+            type_ = rapidjson::kStringType;    // any scalar, saved as is
+            return;
+        }
+
+        const char close = (c == '{') ? '}' : ']';
+        ++p;
+        skip_space(p);
+        while (buffer_[p] != close) {
+            Entry entry{0, 0, 0, 0, false, std::string(), nullptr};
+            if (is_object()) {
+                entry.key_begin = p;
+                entry.key_end = skip_string(p, entry.escaped);
+                if (entry.escaped) {
+                    rapidjson::Document key;
+                    key.Parse(buffer_.data() + entry.key_begin, entry.key_end - entry.key_begin);
+                    entry.name.assign(key.GetString(), key.GetStringLength());
+                }
+                p = entry.key_end;
+                skip_space(p);
+                ++p;    // ':'
+                skip_space(p);
+            }
+            entry.begin = p;
+            entry.end = skip_value(p);
+            p = entry.end;
+            entries_.push_back(std::move(entry));
+            skip_space(p);
+            if (buffer_[p] == ',') {
+                ++p;
+                skip_space(p);
+            }
+        }
+    }
+
+    std::string                 buffer_;
+    rapidjson::ParseResult      result_;
+    rapidjson::Type             type_;
+    size_t                      value_begin_ = 0;
+    size_t                      value_end_ = 0;
+    std::vector<Entry>          entries_;
+    std::shared_ptr<Document>   root_;
+};
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_LAZY_H_
@@ -0,0 +1,108 @@
+#ifndef WRAPIDJSON_MAPPED_FILE_H_
+#define WRAPIDJSON_MAPPED_FILE_H_
+
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define WRAPIDJSON_HAS_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#define WRAPIDJSON_HAS_MMAP 0
+#endif
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Memory mapped file ( POSIX mmap )
+///  - read only  : shared with page cache, parse with length
+///  - writable   : private copy-on-write mapping with '\0' terminator, for in-situ parse
+/////////////////////////////////////////////////////////////////////////////////////////////
+class MappedFile {
+public:
+    MappedFile() : data_(nullptr), size_(0), length_(0) { empty_[0] = '\0'; }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path, bool writable = false);
+    void close();
+
+    char* data() { return data_ != nullptr ? data_ : empty_; }
+    size_t size() const { return size_; }
+
+private:
+    char*   data_;
+    size_t  size_;      // file size
+    size_t  length_;    // mapped length
+    char    empty_[1];  // data of empty file
+};
+
+#if WRAPIDJSON_HAS_MMAP
+inline bool MappedFile::open(const std::string& path, bool writable) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 or not S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* addr = MAP_FAILED;
+    size_t length = size;
+    if (writable) {
+        // reserve one more byte for '\0', tail of last page is always zero filled
+        size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        length = (size + 1 + page - 1) / page * page;
+        void* base = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (base != MAP_FAILED) {
+            addr = ::mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+            if (addr == MAP_FAILED) {
+                ::munmap(base, length);
+            }
+        }
+    } else {
+        addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+
+    data_ = static_cast<char*>(addr);
+    size_ = size;
+    length_ = length;
+    return true;
+}
+
+inline void MappedFile::close() {
+    if (data_ != nullptr) {
+        ::munmap(data_, length_);
+    }
+    data_ = nullptr;
+    size_ = length_ = 0;
+}
+#else
+inline bool MappedFile::open(const std::string&, bool) { return false; }
+inline void MappedFile::close() {}
+#endif
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_MAPPED_FILE_H_
@@ -0,0 +1,122 @@
+#ifndef WRAPIDJSON_MEMBER_INDEX_H_
+#define WRAPIDJSON_MEMBER_INDEX_H_
+
+#include <vector>
+#include <cstdint>
+
+#include <rapidjson/document.h>
+
+#include "key.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Side hash table for wide objects ( open addressing over member positions )
+///  - members are not moved, JSON order is unchanged
+///  - duplicate names resolve to the first member like FindMember
+///  - index is checked against members pointer and count before use, and rebuilt when
+///    the object was reallocated or resized behind its back
+/////////////////////////////////////////////////////////////////////////////////////////////
+class MemberIndex {
+public:
+    static const size_t DEFAULT_THRESHOLD = 32;
+
+    explicit MemberIndex(size_t threshold = DEFAULT_THRESHOLD)
+        : threshold_(threshold), mask_(0), members_(nullptr), count_(0), valid_(false) {}
+
+    size_t threshold() const { return threshold_; }
+
+    /// index applies to object of this size
+    bool enabled(const rapidjson::Value& object) const { return object.MemberCount() >= threshold_; }
+
+    /// member position of key, MemberCount() if not found
+    size_t find(const rapidjson::Value& object, const Key& key) {
+        if (not valid_ or members_ != first(object) or count_ != object.MemberCount()) {
+            build(object);
+        }
+        const rapidjson::Value::Member* members = first(object);
+        for (size_t i = key.hash() & mask_; slots_[i].position != 0; i = (i + 1) & mask_) {
+            if (slots_[i].hash == key.hash()) {
+                const rapidjson::Value& name = members[slots_[i].position - 1].name;
+                if (key.equals(name.GetString(), name.GetStringLength())) {
+                    return slots_[i].position - 1;
+                }
+            }
+        }
+        return count_;
+    }
+
+    /// a member was appended to object
+    void add(const rapidjson::Value& object) {
+        if (not valid_ or count_ + 1 != object.MemberCount()) {
+            valid_ = false;
+            return;
+        }
+        members_ = first(object);
+        count_ = object.MemberCount();
+        if (count_ * 2 > slots_.size()) {
+            build(object);
+            return;
+        }
+        const rapidjson::Value& name = members_[count_ - 1].name;
+        insert(Key(string_view(name.GetString(), name.GetStringLength())), count_ - 1);
+    }
+
+    /// members were erased or reordered
+    void invalidate() { valid_ = false; }
+
+private:
+    struct Slot {
+        uint32_t hash;
+        uint32_t position;  // member position + 1, 0 is empty
+    };
+
+    static const rapidjson::Value::Member* first(const rapidjson::Value& object) {
+        return object.MemberCount() > 0 ? &*object.MemberBegin() : nullptr;
+    }
+
+    void build(const rapidjson::Value& object) {
+        members_ = first(object);
+        count_ = object.MemberCount();
+
+        size_t size = 16;
+        while (size < count_ * 2) {
+            size *= 2;
+        }
+        slots_.assign(size, Slot{0, 0});
+        mask_ = size - 1;
+        for (size_t i = 0; i < count_; ++i) {
+            const rapidjson::Value& name = members_[i].name;
+            insert(Key(string_view(name.GetString(), name.GetStringLength())), i);
+        }
+        valid_ = true;
+    }
+
+    /// keep first member of duplicate names
+    void insert(const Key& key, size_t position) {
+        size_t i = key.hash() & mask_;
+        for (; slots_[i].position != 0; i = (i + 1) & mask_) {
+            if (slots_[i].hash == key.hash()) {
+                const rapidjson::Value& name = members_[slots_[i].position - 1].name;
+                if (key.equals(name.GetString(), name.GetStringLength())) {
+                    return;
+                }
+            }
+        }
+        slots_[i].hash = key.hash();
+        slots_[i].position = static_cast<uint32_t>(position + 1);
+    }
+
+    std::vector<Slot>                   slots_;
+    size_t                              threshold_;
+    size_t                              mask_;
+    const rapidjson::Value::Member*     members_;
+    size_t                              count_;
+    bool                                valid_;
+};
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_MEMBER_INDEX_H_
@@ -0,0 +1,370 @@
+#ifndef WRAPIDJSON_MSGPACK_H_
+#define WRAPIDJSON_MSGPACK_H_
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+#include <rapidjson/document.h>
+#include <rapidjson/error/error.h>
+
+namespace wrapidjson {
+namespace detail {
+namespace msgpack {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// MessagePack encoding of rapidjson::Value
+///  - integers use the smallest format, doubles use float32 when exact, else float64
+///  - strings are str ( also for kParseNumbersAsStringsFlag numbers ), object keys too
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Encoder {
+public:
+    explicit Encoder(std::string& out) : out_(out) {}
+
+    void encode(const rapidjson::Value& value) {
+        switch (value.GetType()) {
+        case rapidjson::kNullType:
+            put(0xc0);
+            break;
+        case rapidjson::kFalseType:
+            put(0xc2);
+            break;
+        case rapidjson::kTrueType:
+            put(0xc3);
+            break;
+        case rapidjson::kStringType:
+            encode_string(value.GetString(), value.GetStringLength());
+            break;
+        case rapidjson::kNumberType:
+            encode_number(value);
+            break;
+        case rapidjson::kArrayType:
+            encode_header(value.Size(), 0x90, 16, 0xdc, 0xdd);
+            for (auto it = value.Begin(); it != value.End(); ++it) {
+                encode(*it);
+            }
+            break;
+        case rapidjson::kObjectType:
+            encode_header(value.MemberCount(), 0x80, 16, 0xde, 0xdf);
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                encode_string(it->name.GetString(), it->name.GetStringLength());
+                encode(it->value);
+            }
+            break;
+        }
+    }
+
+private:
+    void put(unsigned c) { out_.push_back(static_cast<char>(c)); }
+
+    /// tag and big endian value of N bytes
+    template<size_t N>
+    void put_be(unsigned tag, uint64_t v) {
+        char bytes[N + 1];
+        bytes[0] = static_cast<char>(tag);
+        for (size_t i = 0; i < N; ++i) {
+            bytes[N - i] = static_cast<char>(v >> (8 * i));
+        }
+        out_.append(bytes, N + 1);
+    }
+
+    /// fixed ( count < fix_limit ), 16 bit or 32 bit count
+    void encode_header(uint32_t n, unsigned fix, uint32_t fix_limit, unsigned tag16, unsigned tag32) {
+        if (n < fix_limit) {
+            put(fix | n);
+        } else if (n <= 0xffff) {
+            put_be<2>(tag16, n);
+        } else {
+            put_be<4>(tag32, n);
+        }
+    }
+
+    void encode_string(const char* s, uint32_t n) {
+        if (n < 32) {
+            put(0xa0 | n);
+        } else if (n <= 0xff) {
+            put_be<1>(0xd9, n);
+        } else {
+            encode_header(n, 0, 0, 0xda, 0xdb);
+        }
+        out_.append(s, n);
+    }
+
+    void encode_number(const rapidjson::Value& value) {
+        if (value.IsUint64()) {
+            uint64_t v = value.GetUint64();
+            if (v < 0x80) {
+                put(static_cast<unsigned>(v));
+            } else if (v <= 0xff) {
+                put_be<1>(0xcc, v);
+            } else if (v <= 0xffff) {
+                put_be<2>(0xcd, v);
+            } else if (v <= 0xffffffffu) {
+                put_be<4>(0xce, v);
+            } else {
+                put_be<8>(0xcf, v);
+            }
+        } else if (value.IsInt64()) {
+            int64_t v = value.GetInt64();      // negative here
+            if (v >= -32) {
+                put(static_cast<unsigned>(v) & 0xff);
+            } else if (v >= INT8_MIN) {
+                put_be<1>(0xd0, static_cast<uint64_t>(v));
+            } else if (v >= INT16_MIN) {
+                put_be<2>(0xd1, static_cast<uint64_t>(v));
+            } else if (v >= INT32_MIN) {
+                put_be<4>(0xd2, static_cast<uint64_t>(v));
+            } else {
+                put_be<8>(0xd3, static_cast<uint64_t>(v));
+            }
+        } else {
+            double d = value.GetDouble();
+            float f = static_cast<float>(d);
+            if (static_cast<double>(f) == d) {
+                uint32_t bits;
+                memcpy(&bits, &f, sizeof(bits));
+                put_be<4>(0xca, bits);
+            } else {
+                uint64_t bits;
+                memcpy(&bits, &d, sizeof(bits));
+                put_be<8>(0xcb, bits);
+            }
+        }
+    }
+
+    std::string& out_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// MessagePack to rapidjson SAX events ( Document::Populate, Writer for msgpack to JSON )
+///  - bin is read as string, ext and non string map keys are invalid
+///  - counts are checked against remaining bytes before any handler call
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Decoder {
+public:
+    static const unsigned MAX_DEPTH = 512;
+
+    Decoder(const char* data, size_t size)
+        : begin_(reinterpret_cast<const unsigned char*>(data)), p_(begin_), end_(begin_ + size) {}
+
+    /// one value and nothing after it
+    template<typename Handler>
+    bool operator()(Handler& handler) {
+        if (p_ == end_) {
+            return fail(rapidjson::kParseErrorDocumentEmpty);
+        }
+        if (not decode(handler, 0)) {
+            return false;
+        }
+        if (p_ != end_) {
+            return fail(rapidjson::kParseErrorDocumentRootNotSingular);
+        }
+        return true;
+    }
+
+    const rapidjson::ParseResult& result() const { return result_; }
+
+private:
+    bool fail(rapidjson::ParseErrorCode code) {
+        result_.Set(code, static_cast<size_t>(p_ - begin_));
+        return false;
+    }
+
+    bool has(size_t n) const { return static_cast<size_t>(end_ - p_) >= n; }
+
+    /// big endian value of N bytes ( has(N) is checked )
+    template<size_t N>
+    uint64_t read_be() {
+        uint64_t v = 0;
+        for (size_t i = 0; i < N; ++i) {
+            v = (v << 8) | p_[i];
+        }
+        p_ += N;
+        return v;
+    }
+
+    /// length of N bytes
+    template<size_t N>
+    bool read_length(uint32_t& n) {
+        if (not has(N)) {
+            return fail(rapidjson::kParseErrorValueInvalid);
+        }
+        n = static_cast<uint32_t>(read_be<N>());
+        return true;
+    }
+
+    template<typename Handler>
+    bool decode_string(Handler& handler, uint32_t n, bool key) {
+        if (not has(n)) {
+            return fail(rapidjson::kParseErrorValueInvalid);
+        }
+        const char* s = reinterpret_cast<const char*>(p_);
+        p_ += n;
+        return handled(key ? handler.Key(s, n, true) : handler.String(s, n, true));
+    }
+
+    template<typename Handler>
+    bool decode_array(Handler& handler, uint32_t n, unsigned depth) {
+        if (not has(n)) {      // at least one byte per element
+            return fail(rapidjson::kParseErrorValueInvalid);
+        }
+        if (not handled(handler.StartArray())) {
+            return false;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            if (not decode(handler, depth + 1)) {
+                return false;
+            }
+        }
+        return handled(handler.EndArray(n));
+    }
+
+    template<typename Handler>
+    bool decode_map(Handler& handler, uint32_t n, unsigned depth) {
+        if (n > static_cast<size_t>(end_ - p_) / 2) {  // at least two bytes per member
+            return fail(rapidjson::kParseErrorValueInvalid);
+        }
+        if (not handled(handler.StartObject())) {
+            return false;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            if (not decode_key(handler) or not decode(handler, depth + 1)) {
+                return false;
+            }
+        }
+        return handled(handler.EndObject(n));
+    }
+
+    template<typename Handler>
+    bool decode_key(Handler& handler) {
+        if (not has(1)) {
+            return fail(rapidjson::kParseErrorObjectMissName);
+        }
+        unsigned c = *p_++;
+        uint32_t n = 0;
+        if ((c & 0xe0) == 0xa0) {
+            return decode_string(handler, c & 0x1f, true);
+        }
+        switch (c) {
+        case 0xd9: case 0xc4: return read_length<1>(n) and decode_string(handler, n, true);
+        case 0xda: case 0xc5: return read_length<2>(n) and decode_string(handler, n, true);
+        case 0xdb: case 0xc6: return read_length<4>(n) and decode_string(handler, n, true);
+        default:
+            --p_;
+            return fail(rapidjson::kParseErrorObjectMissName);
+        }
+    }
+
+    /// handler returned false
+    bool handled(bool ok) {
+        return ok or fail(rapidjson::kParseErrorTermination);
+    }
+
+    /// fixed size integer to Uint / Uint64 / Int / Int64
+    template<typename Handler>
+    static bool emit(Handler& handler, uint8_t v) { return handler.Uint(v); }
+    template<typename Handler>
+    static bool emit(Handler& handler, uint16_t v) { return handler.Uint(v); }
+    template<typename Handler>
+    static bool emit(Handler& handler, uint32_t v) { return handler.Uint(v); }
+    template<typename Handler>
+    static bool emit(Handler& handler, uint64_t v) { return handler.Uint64(v); }
+    template<typename Handler>
+    static bool emit(Handler& handler, int8_t v) { return handler.Int(v); }
+    template<typename Handler>
+    static bool emit(Handler& handler, int16_t v) { return handler.Int(v); }
+    template<typename Handler>
+    static bool emit(Handler& handler, int32_t v) { return handler.Int(v); }
+    template<typename Handler>
+    static bool emit(Handler& handler, int64_t v) { return handler.Int64(v); }
+
+    /// uint8 .. uint64, int8 .. int64
+    template<typename T, typename Handler>
+    bool decode_number(Handler& handler) {
+        if (not has(sizeof(T))) {
+            return fail(rapidjson::kParseErrorValueInvalid);
+        }
+        return handled(emit(handler, static_cast<T>(read_be<sizeof(T)>())));
+    }
+
+    template<typename Handler>
+    bool decode_float(Handler& handler) {
+        if (not has(4)) {
+            return fail(rapidjson::kParseErrorValueInvalid);
+        }
+        uint32_t bits = static_cast<uint32_t>(read_be<4>());
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        return handled(handler.Double(f));
+    }
+
+    template<typename Handler>
+    bool decode_double(Handler& handler) {
+        if (not has(8)) {
+            return fail(rapidjson::kParseErrorValueInvalid);
+        }
+        uint64_t bits = read_be<8>();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        return handled(handler.Double(d));
+    }
+
+    template<typename Handler>
+    bool decode(Handler& handler, unsigned depth) {
+        if (depth >= MAX_DEPTH) {
+            return fail(rapidjson::kParseErrorTermination);
+        }
+        if (not has(1)) {
+            return fail(rapidjson::kParseErrorValueInvalid);
+        }
+        unsigned c = *p_++;
+        uint32_t n = 0;
+        if (c < 0x80) {
+            return handled(handler.Uint(c));                        // positive fixint
+        } else if (c >= 0xe0) {
+            return handled(handler.Int(static_cast<int>(c) - 0x100)); // negative fixint
+        } else if ((c & 0xe0) == 0xa0) {
+            return decode_string(handler, c & 0x1f, false);
+        } else if ((c & 0xf0) == 0x90) {
+            return decode_array(handler, c & 0x0f, depth);
+        } else if ((c & 0xf0) == 0x80) {
+            return decode_map(handler, c & 0x0f, depth);
+        }
+        switch (c) {
+        case 0xc0: return handled(handler.Null());
+        case 0xc2: return handled(handler.Bool(false));
+        case 0xc3: return handled(handler.Bool(true));
+        case 0xcc: return decode_number<uint8_t>(handler);
+        case 0xcd: return decode_number<uint16_t>(handler);
+        case 0xce: return decode_number<uint32_t>(handler);
+        case 0xcf: return decode_number<uint64_t>(handler);
+        case 0xd0: return decode_number<int8_t>(handler);
+        case 0xd1: return decode_number<int16_t>(handler);
+        case 0xd2: return decode_number<int32_t>(handler);
+        case 0xd3: return decode_number<int64_t>(handler);
+        case 0xca: return decode_float(handler);
+        case 0xcb: return decode_double(handler);
+        case 0xd9: case 0xc4: return read_length<1>(n) and decode_string(handler, n, false);
+        case 0xda: case 0xc5: return read_length<2>(n) and decode_string(handler, n, false);
+        case 0xdb: case 0xc6: return read_length<4>(n) and decode_string(handler, n, false);
+        case 0xdc: return read_length<2>(n) and decode_array(handler, n, depth);
+        case 0xdd: return read_length<4>(n) and decode_array(handler, n, depth);
+        case 0xde: return read_length<2>(n) and decode_map(handler, n, depth);
+        case 0xdf: return read_length<4>(n) and decode_map(handler, n, depth);
+        default:
+            --p_;
+            return fail(rapidjson::kParseErrorValueInvalid);   // 0xc1, ext
+        }
+    }
+
+    const unsigned char*    begin_;
+    const unsigned char*    p_;
+    const unsigned char*    end_;
+    rapidjson::ParseResult  result_;
+};
+
+} // namespace msgpack
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_MSGPACK_H_
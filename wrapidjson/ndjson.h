@@ -0,0 +1,457 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_NDJSON_H_
+#define WRAPIDJSON_NDJSON_H_
+
+#include <string>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <exception>
+
+#include "document.h"
+#include "mapped_file.h"
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Newline delimited JSON reader
+///  - one Document per line, Document and Arena are recycled between records
+///  - Document passed to callback is valid only in callback
+///  - callback returns false to stop reading
+///  - blank lines are skipped
+/////////////////////////////////////////////////////////////////////////////////////////////
+class NdjsonReader {
+public:
+    using Callback = std::function<bool(Document&)>;
+
+    /// stop_on_error : stop at first invalid record, or skip it and continue
+    explicit NdjsonReader(bool stop_on_error = true, size_t arena_capacity = Arena::DEFAULT_CAPACITY)
+        : stop_on_error_(stop_on_error)
+        , arena_(arena_capacity)
+        , document_(arena_)
+    {
+        clear();
+    }
+    NdjsonReader(const NdjsonReader&) = delete;
+    NdjsonReader& operator=(const NdjsonReader&) = delete;
+    ~NdjsonReader() = default;
+
+    /// read NDJSON data ( false if any record is invalid )
+    bool read_from_buffer(const string_view& buffer, const Callback& func);
+    bool read_from_file(const std::string& path, const Callback& func);
+    bool read_from_stream(std::istream& is, const Callback& func);
+
+    /// line number of last read line ( 1-based )
+    size_t line() const { return line_; }
+    /// records passed to callback
+    size_t count() const { return count_; }
+    /// invalid records
+    size_t error_count() const { return error_count_; }
+
+    /// first invalid record : line number, and byte offset from start of input
+    size_t error_line() const { return error_line_; }
+    size_t error_offset() const { return error_offset_; }
+    rapidjson::ParseErrorCode error_code() const { return error_code_; }
+    std::string get_read_error() const;
+
+private:
+    void clear() {
+        line_ = count_ = error_count_ = error_line_ = error_offset_ = 0;
+        error_code_ = rapidjson::kParseErrorNone;
+        stopped_ = false;
+    }
+
+    static bool is_blank(const char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            if (data[i] != ' ' and data[i] != '\t' and data[i] != '\r') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// parse one line, false to stop reading
+    bool read_line(const char* data, size_t size, size_t offset, const Callback& func);
+
+    bool                        stop_on_error_;
+    Arena                       arena_;
+    Document                    document_;
+    std::string                 line_buffer_;   // for stream
+
+    size_t                      line_;
+    size_t                      count_;
+    size_t                      error_count_;
+    size_t                      error_line_;
+    size_t                      error_offset_;
+    rapidjson::ParseErrorCode   error_code_;
+    bool                        stopped_;
+};
+
+inline bool NdjsonReader::read_line(const char* data, size_t size, size_t offset, const Callback& func) {
+    ++line_;
+    if (is_blank(data, size)) {
+        return true;
+    }
+
+    document_.reset();
+    if (not document_.load_from_buffer(string_view(data, size))) {
+        if (error_count_++ == 0) {
+            error_line_ = line_;
+            error_offset_ = offset + document_.get_document().GetErrorOffset();
+            error_code_ = document_.get_document().GetParseError();
+        }
+        return not stop_on_error_;
+    }
+
+    ++count_;
+    if (not func(document_)) {
+        stopped_ = true;
+    }
+    return not stopped_;
+}
+
+inline bool NdjsonReader::read_from_buffer(const string_view& buffer, const Callback& func) {
+    clear();
+    const char* begin = buffer.data();
+    const char* end = begin + buffer.size();
+    for (const char* p = begin; p < end; ) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        const char* line_end = (nl != nullptr) ? nl : end;
+        if (not read_line(p, line_end - p, p - begin, func)) {
+            break;
+        }
+        p = (nl != nullptr) ? nl + 1 : end;
+    }
+    document_.reset();
+    return error_count_ == 0;
+}
+
+inline bool NdjsonReader::read_from_file(const std::string& path, const Callback& func) {
+    detail::MappedFile file;
+    if (file.open(path)) {
+        return read_from_buffer(string_view(file.data(), file.size()), func);
+    }
+
+    std::ifstream ifs(path, std::ios::in | std::ios::binary);
+    if (not ifs) {
+        clear();
+        return false;
+    }
+    return read_from_stream(ifs, func);
+}
+
+inline bool NdjsonReader::read_from_stream(std::istream& is, const Callback& func) {
+    clear();
+    size_t offset = 0;
+    while (std::getline(is, line_buffer_)) {
+        if (not read_line(line_buffer_.data(), line_buffer_.size(), offset, func)) {
+            break;
+        }
+        offset += line_buffer_.size() + 1;
+    }
+    document_.reset();
+    return error_count_ == 0;
+}
+
+inline std::string NdjsonReader::get_read_error() const {
+    return detail::format("Error line[%u] offset[%u]: %s",
+            (unsigned)error_line_, (unsigned)error_offset_,
+            rapidjson::GetParseError_En(error_code_));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Parallel newline delimited JSON reader
+///  - input is split at newline boundaries, chunks are parsed on worker threads
+///  - every worker has own NdjsonReader ( Arena and Document )
+///  - read_from_*      : callback is called concurrently and unordered, must be thread safe
+///  - transform_from_* : results are returned in record order
+///  - error is reported for first invalid record in input order
+///  - stop_on_error    : line, count and results end at first invalid record like NdjsonReader
+///                       ( read_from_* callback may already have seen some records after it )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ParallelNdjsonReader {
+public:
+    using Callback = NdjsonReader::Callback;
+    static const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+    /// threads : 0 is std::thread::hardware_concurrency()
+    explicit ParallelNdjsonReader(size_t threads = 0, bool stop_on_error = true,
+            size_t min_chunk_size = MIN_CHUNK_SIZE)
+        : threads_(threads > 0 ? threads : std::thread::hardware_concurrency())
+        , stop_on_error_(stop_on_error)
+        , min_chunk_size_(min_chunk_size > 0 ? min_chunk_size : 1)
+    {
+        if (threads_ == 0) {
+            threads_ = 1;
+        }
+        clear();
+    }
+    ~ParallelNdjsonReader() = default;
+
+    /// read NDJSON data, func is called from worker threads
+    bool read_from_buffer(const string_view& buffer, const Callback& func);
+    bool read_from_file(const std::string& path, const Callback& func);
+
+    /// read NDJSON data, func is called from worker threads, results are in record order
+    template<typename T>
+    bool transform_from_buffer(const string_view& buffer,
+            const std::function<T(Document&)>& func, std::vector<T>& results);
+    template<typename T>
+    bool transform_from_file(const std::string& path,
+            const std::function<T(Document&)>& func, std::vector<T>& results);
+
+    size_t line() const { return line_; }
+    size_t count() const { return count_; }
+    size_t error_count() const { return error_count_; }
+    size_t error_line() const { return error_line_; }
+    size_t error_offset() const { return error_offset_; }
+    std::string get_read_error() const;
+
+private:
+    struct ChunkResult {
+        size_t                      line = 0;
+        size_t                      count = 0;
+        size_t                      error_count = 0;
+        size_t                      error_line = 0;
+        size_t                      error_offset = 0;
+        rapidjson::ParseErrorCode   error_code = rapidjson::kParseErrorNone;
+    };
+
+    void clear() {
+        line_ = count_ = error_count_ = error_line_ = error_offset_ = 0;
+        error_code_ = rapidjson::kParseErrorNone;
+    }
+
+    std::vector<string_view> split(const string_view& buffer) const;
+
+    /// make_callback(chunk_index) gives callback of each chunk, chunks are from split(buffer).
+    /// kept : number of leading chunks whose records count, later ones follow first invalid record
+    bool run(const string_view& buffer, const std::vector<string_view>& chunks,
+            const std::function<Callback(size_t)>& make_callback, size_t& kept);
+
+    template<typename Func>
+    bool with_file(const std::string& path, Func func);
+
+    size_t                      threads_;
+    bool                        stop_on_error_;
+    size_t                      min_chunk_size_;
+
+    size_t                      line_;
+    size_t                      count_;
+    size_t                      error_count_;
+    size_t                      error_line_;
+    size_t                      error_offset_;
+    rapidjson::ParseErrorCode   error_code_;
+};
+
+inline std::vector<string_view> ParallelNdjsonReader::split(const string_view& buffer) const {
+    std::vector<string_view> chunks;
+    size_t n = buffer.size() / min_chunk_size_;
+    n = (n < 1) ? 1 : (n > threads_ ? threads_ : n);
+
+    const char* begin = buffer.data();
+    const char* end = begin + buffer.size();
+    const char* p = begin;
+    for (size_t i = 1; i <= n and p < end; ++i) {
+        const char* q = (i == n) ? end : begin + buffer.size() / n * i;
+        if (q < p) {
+            q = p;
+        }
+        if (q < end) {
+            const char* nl = static_cast<const char*>(memchr(q, '\n', end - q));
+            q = (nl != nullptr) ? nl + 1 : end;
+        }
+        chunks.emplace_back(p, q - p);
+        p = q;
+    }
+    return chunks;
+}
+
+inline bool ParallelNdjsonReader::run(const string_view& buffer, const std::vector<string_view>& chunks,
+        const std::function<Callback(size_t)>& make_callback, size_t& kept)
+{
+    clear();
+    const size_t n = chunks.size();
+
+    std::vector<ChunkResult> results(n);
+    std::vector<std::exception_ptr> exceptions(n);
+    std::atomic<size_t> first_failed(n);    // chunks after first failed chunk are cancelled
+    std::atomic<bool> stopped(false);       // callback returned false
+
+    auto work = [&](size_t i) {
+        try {
+            NdjsonReader reader(stop_on_error_);
+            Callback callback = make_callback(i);
+            reader.read_from_buffer(chunks[i], [&](Document& doc) -> bool {
+                if (stopped.load(std::memory_order_relaxed) or
+                        first_failed.load(std::memory_order_relaxed) < i) {
+                    return false;
+                }
+                if (not callback(doc)) {
+                    stopped.store(true, std::memory_order_relaxed);
+                    return false;
+                }
+                return true;
+            });
+
+            if (reader.error_count() > 0 and stop_on_error_) {
+                size_t failed = first_failed.load();
+                while (i < failed and not first_failed.compare_exchange_weak(failed, i)) {}
+            }
+            ChunkResult& result = results[i];
+            result.line = reader.line();
+            result.count = reader.count();
+            result.error_count = reader.error_count();
+            result.error_line = reader.error_line();
+            result.error_offset = reader.error_offset();
+            result.error_code = reader.error_code();
+        } catch (...) {
+            exceptions[i] = std::current_exception();
+            stopped.store(true);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(n);
+    for (size_t i = 1; i < n; ++i) {
+        workers.emplace_back(work, i);
+    }
+    work(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& exception : exceptions) {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    // stop_on_error : chunks after first failed one may have finished before it failed,
+    // drop them so that line, count and error are the same as NdjsonReader
+    kept = n;
+    if (stop_on_error_) {
+        for (size_t i = 0; i < n; ++i) {
+            if (results[i].error_count > 0) {
+                kept = i + 1;
+                break;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < kept; ++i) {
+        const ChunkResult& result = results[i];
+        if (result.error_count > 0 and error_count_ == 0) {
+            error_line_ = line_ + result.error_line;
+            error_offset_ = static_cast<size_t>(chunks[i].data() - buffer.data()) + result.error_offset;
+            error_code_ = result.error_code;
+        }
+        line_ += result.line;
+        count_ += result.count;
+        error_count_ += result.error_count;
+    }
+    return error_count_ == 0;
+}
+
+template<typename Func>
+inline bool ParallelNdjsonReader::with_file(const std::string& path, Func func) {
+    detail::MappedFile file;
+    if (file.open(path)) {
+        return func(string_view(file.data(), file.size()));
+    }
+
+    // without mmap, read whole file
+    std::ifstream ifs(path, std::ios::in | std::ios::binary);
+    if (not ifs) {
+        clear();
+        return false;
+    }
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    const std::string buffer = ss.str();
+    return func(string_view(buffer));
+}
+
+inline bool ParallelNdjsonReader::read_from_buffer(const string_view& buffer, const Callback& func) {
+    size_t kept = 0;
+    return run(buffer, split(buffer), [&func](size_t) { return func; }, kept);
+}
+
+inline bool ParallelNdjsonReader::read_from_file(const std::string& path, const Callback& func) {
+    return with_file(path, [&](const string_view& buffer) {
+        return read_from_buffer(buffer, func);
+    });
+}
+
+template<typename T>
+inline bool ParallelNdjsonReader::transform_from_buffer(const string_view& buffer,
+        const std::function<T(Document&)>& func, std::vector<T>& results)
+{
+    const std::vector<string_view> chunks = split(buffer);
+    std::vector<std::vector<T>> partial(chunks.size());
+    size_t kept = 0;
+    bool ret = run(buffer, chunks, [&](size_t i) -> Callback {
+        std::vector<T>* out = &partial[i];
+        return [out, &func](Document& doc) -> bool {
+            out->emplace_back(func(doc));
+            return true;
+        };
+    }, kept);
+    partial.resize(kept);   // drop outputs of chunks after first invalid record
+
+    results.clear();
+    size_t total = 0;
+    for (const auto& part : partial) {
+        total += part.size();
+    }
+    results.reserve(total);
+    for (auto& part : partial) {
+        std::move(part.begin(), part.end(), std::back_inserter(results));
+    }
+    return ret;
+}
+
+template<typename T>
+inline bool ParallelNdjsonReader::transform_from_file(const std::string& path,
+        const std::function<T(Document&)>& func, std::vector<T>& results)
+{
+    return with_file(path, [&](const string_view& buffer) {
+        return transform_from_buffer(buffer, func, results);
+    });
+}
+
+inline std::string ParallelNdjsonReader::get_read_error() const {
+    return detail::format("Error line[%u] offset[%u]: %s",
+            (unsigned)error_line_, (unsigned)error_offset_,
+            rapidjson::GetParseError_En(error_code_));
+}
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_NDJSON_H_
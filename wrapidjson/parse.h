@@ -2,92 +2,340 @@
 #define WRAPIDJSON_PARSE_H_
 
 #include <string>
-#include <sstream>
-#include <vector>
-#include <cstdio>
-#include <cstdlib>
-#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+
+#include <rapidjson/reader.h>
+#include <rapidjson/stream.h>
 
 #include "optional.hpp"
+#include "string_view.hpp"
 #include "type_traits.h"
 
+// SWAR digit parsing loads 8 bytes as little endian word
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+#  if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#    define WRAPIDJSON_SWAR_DIGITS 1
+#  endif
+#elif defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64)
+#  define WRAPIDJSON_SWAR_DIGITS 1
+#endif
+#ifndef WRAPIDJSON_SWAR_DIGITS
+#  define WRAPIDJSON_SWAR_DIGITS 0
+#endif
+
 namespace wrapidjson {
 namespace detail {
 
 template<typename T>
 using optional = nonstd::optional<T>;
 
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// locale free number parsing on pointer + length ( no copy, no errno )
+///  - leading whitespace and sign are accepted ( like strtol ), trailing characters are not
+/////////////////////////////////////////////////////////////////////////////////////////////
+namespace parse_helper {
+
+inline bool is_space(char c) {
+    return c == ' ' or c == '\t' or c == '\n' or c == '\v' or c == '\f' or c == '\r';
+}
+
+inline bool is_digit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+inline char to_lower(char c) {
+    return (c >= 'A' and c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+/// case insensitive compare with lower case literal
+inline bool equals_lower(const char* s, size_t n, const char* lower) {
+    size_t i = 0;
+    for (; i < n and lower[i] != '\0'; ++i) {
+        if (to_lower(s[i]) != lower[i]) {
+            return false;
+        }
+    }
+    return i == n and lower[i] == '\0';
+}
+
+inline void skip_space(const char*& p, const char* end) {
+    while (p < end and is_space(*p)) {
+        ++p;
+    }
+}
+
+#if WRAPIDJSON_SWAR_DIGITS
+inline uint64_t load8(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/// all 8 bytes are '0'..'9'
+inline bool is_eight_digits(uint64_t v) {
+    return (((v & 0xF0F0F0F0F0F0F0F0ull) |
+            (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull);
+}
+
+/// 8 ascii digits to number, 3 multiplications
+inline uint32_t parse_eight_digits(uint64_t v) {
+    v = (v & 0x0F0F0F0F0F0F0F0Full) * 2561 >> 8;
+    v = (v & 0x00FF00FF00FF00FFull) * 6553601 >> 16;
+    return static_cast<uint32_t>((v & 0x0000FFFF0000FFFFull) * 42949672960001ull >> 32);
+}
+#endif
+
+/// accumulate digits of [p, end) into value while they are digits, no overflow check
+inline const char* accumulate_digits(const char* p, const char* end, uint64_t& value) {
+#if WRAPIDJSON_SWAR_DIGITS
+    while (end - p >= 8) {
+        uint64_t v = load8(p);
+        if (not is_eight_digits(v)) {
+            break;
+        }
+        value = value * 100000000ull + parse_eight_digits(v);
+        p += 8;
+    }
+#endif
+    while (p < end and is_digit(*p)) {
+        value = value * 10 + static_cast<uint64_t>(*p - '0');
+        ++p;
+    }
+    return p;
+}
+
+/// digits only, false on empty, non digit or overflow
+inline bool parse_uint64(const char* p, const char* end, uint64_t& value) {
+    if (p == end) {
+        return false;
+    }
+    while (p < end and *p == '0') {
+        ++p;
+    }
+    size_t n = static_cast<size_t>(end - p);
+    if (n > 20) {
+        return false;
+    }
+
+    // 19 digits always fit in uint64_t
+    value = 0;
+    const char* head_end = n > 19 ? p + 19 : end;
+    if (accumulate_digits(p, head_end, value) != head_end) {
+        return false;
+    }
+    if (n == 20) {
+        if (not is_digit(p[19])) {
+            return false;
+        }
+        uint64_t digit = static_cast<uint64_t>(p[19] - '0');
+        if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+/// sign and magnitude
+inline bool parse_integer(const char* p, const char* end, bool& negative, uint64_t& magnitude) {
+    skip_space(p, end);
+    negative = false;
+    if (p < end and (*p == '-' or *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+    return parse_uint64(p, end, magnitude);
+}
+
+/// rapidjson handler for full precision fallback
+struct DoubleHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, DoubleHandler> {
+    double value = 0;
+    bool Double(double d) { value = d; return true; }
+    bool Int(int i) { value = i; return true; }
+    bool Uint(unsigned u) { value = u; return true; }
+    bool Int64(int64_t i) { value = static_cast<double>(i); return true; }
+    bool Uint64(uint64_t u) { value = static_cast<double>(u); return true; }
+    bool Default() { return false; }
+};
+
+/// correctly rounded conversion of canonical JSON number by rapidjson
+inline bool parse_double_slow(const std::string& number, double& value) {
+    DoubleHandler handler;
+    rapidjson::Reader reader;
+    rapidjson::StringStream ss(number.c_str());
+    if (reader.Parse<rapidjson::kParseFullPrecisionFlag>(ss, handler).IsError()) {
+        return false;
+    }
+    value = handler.value;
+    return true;
+}
+
+inline bool parse_double(const char* p, const char* end, double& value) {
+    static const double POW10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    skip_space(p, end);
+    bool negative = false;
+    if (p < end and (*p == '-' or *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    size_t rest = static_cast<size_t>(end - p);
+    if (equals_lower(p, rest, "inf") or equals_lower(p, rest, "infinity")) {
+        value = negative ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+        return true;
+    } else if (equals_lower(p, rest, "nan")) {
+        value = std::numeric_limits<double>::quiet_NaN();
+        return true;
+    }
+
+    // [digits][.digits][(e|E)[sign]digits]
+    const char* int_begin = p;
+    while (p < end and is_digit(*p)) {
+        ++p;
+    }
+    const char* int_end = p;
+    const char* frac_begin = p;
+    const char* frac_end = p;
+    if (p < end and *p == '.') {
+        frac_begin = ++p;
+        while (p < end and is_digit(*p)) {
+            ++p;
+        }
+        frac_end = p;
+    }
+    if (int_begin == int_end and frac_begin == frac_end) {
+        return false;
+    }
+
+    int exponent = 0;
+    bool has_exponent = false;
+    if (p < end and (*p == 'e' or *p == 'E')) {
+        ++p;
+        bool exp_negative = false;
+        if (p < end and (*p == '-' or *p == '+')) {
+            exp_negative = (*p == '-');
+            ++p;
+        }
+        if (p == end or not is_digit(*p)) {
+            return false;
+        }
+        for (; p < end and is_digit(*p); ++p) {
+            if (exponent < 100000) {    // clamp, result is 0 or inf anyway
+                exponent = exponent * 10 + (*p - '0');
+            }
+        }
+        exponent = exp_negative ? -exponent : exponent;
+        has_exponent = true;
+    }
+    if (p != end) {
+        return false;
+    }
+
+    // Clinger fast path : mantissa and power of ten are both exact doubles
+    while (int_begin < int_end and *int_begin == '0') {
+        ++int_begin;
+    }
+    size_t int_digits = static_cast<size_t>(int_end - int_begin);
+    size_t frac_digits = static_cast<size_t>(frac_end - frac_begin);
+    if (int_digits + frac_digits <= 19) {
+        uint64_t mantissa = 0;
+        accumulate_digits(int_begin, int_end, mantissa);
+        accumulate_digits(frac_begin, frac_end, mantissa);
+        int exp10 = exponent - static_cast<int>(frac_digits);
+        if (mantissa == 0) {
+            value = negative ? -0.0 : 0.0;
+            return true;
+        }
+        if (mantissa <= (1ull << 53) and exp10 >= -22 and exp10 <= 22) {
+            double d = static_cast<double>(mantissa);
+            d = exp10 < 0 ? d / POW10[-exp10] : d * POW10[exp10];
+            value = negative ? -d : d;
+            return true;
+        }
+    }
+
+    // canonical JSON number for rapidjson full precision parser
+    std::string number;
+    number.reserve(static_cast<size_t>(end - int_begin) + 16);
+    if (negative) {
+        number.push_back('-');
+    }
+    if (int_begin == int_end) {
+        number.push_back('0');
+    } else {
+        number.append(int_begin, int_end);
+    }
+    if (frac_begin != frac_end) {
+        number.push_back('.');
+        number.append(frac_begin, frac_end);
+    }
+    if (has_exponent) {
+        number.push_back('e');
+        number.append(std::to_string(exponent));
+    }
+    return parse_double_slow(number, value);
+}
+
+} // namespace parse_helper
+
 template<typename T, enable_if_bool_t<T>* = nullptr>
-inline optional<bool> parse(const std::string& value) {
+inline optional<bool> parse(const nonstd::string_view& value) {
     optional<bool> res;
-    if( not value.empty() ) {
-        std::string lower_value_string = value;
-        std::transform(lower_value_string.begin(),
-            lower_value_string.end(),
-            lower_value_string.begin(),
-            ::tolower);
-        if (lower_value_string == "true" or lower_value_string == "false") {
-            res = ("true" == lower_value_string);
-        }
+    if (parse_helper::equals_lower(value.data(), value.size(), "true")) {
+        res = true;
+    } else if (parse_helper::equals_lower(value.data(), value.size(), "false")) {
+        res = false;
     }
     return res;
 }
 
 template<typename T, enable_if_signed_t<T>* = nullptr>
-inline optional<T> parse(const std::string& value) {
+inline optional<T> parse(const nonstd::string_view& value) {
     optional<T> res;
-    if ( not value.empty() ) {
-        const char* const value_c_str = value.c_str();
-        char* end;
-        errno = 0;
-        const long lvalue = strtol(value_c_str, &end, 10);
-        if ( end != value_c_str and '\0' == *end
-                and lvalue <= std::numeric_limits<T>::max()
-                and lvalue >= std::numeric_limits<T>::min()
-                and errno != ERANGE)    // overflow check
-        {
-            res = static_cast<T>(lvalue);
+    bool negative;
+    uint64_t magnitude;
+    if (parse_helper::parse_integer(value.data(), value.data() + value.size(), negative, magnitude)) {
+        const uint64_t max = static_cast<uint64_t>(std::numeric_limits<T>::max());
+        if (not negative and magnitude <= max) {
+            res = static_cast<T>(magnitude);
+        } else if (negative and magnitude <= max + 1) {
+            // -(magnitude) without overflow for min()
+            res = static_cast<T>(magnitude == 0 ? 0 : -static_cast<int64_t>(magnitude - 1) - 1);
         }
     }
     return res;
 }
 
 template<typename T, enable_if_unsigned_t<T>* = nullptr>
-inline optional<T> parse(const std::string& value) {
+inline optional<T> parse(const nonstd::string_view& value) {
     optional<T> res;
-    if ( not value.empty() and value.find("-") == std::string::npos ) {
-        const char* const value_c_str = value.c_str();
-        char* end;
-        errno = 0;
-        const unsigned long lvalue = strtoul(value_c_str, &end, 10);
-        if ( end != value_c_str and '\0' == *end
-                and lvalue <= std::numeric_limits<T>::max()
-                and lvalue >= std::numeric_limits<T>::min()
-                and errno != ERANGE)    // overflow check
-        {
-            res = static_cast<T>(lvalue);
-        }
+    bool negative;
+    uint64_t magnitude;
+    if (parse_helper::parse_integer(value.data(), value.data() + value.size(), negative, magnitude)
+            and not negative and magnitude <= std::numeric_limits<T>::max()) {
+        res = static_cast<T>(magnitude);
     }
     return res;
 }
 
 template<typename T, enable_if_float_t<T>* = nullptr>
-inline optional<T> parse(const std::string& value) {
+inline optional<T> parse(const nonstd::string_view& value) {
     optional<T> res;
-    if ( not value.empty() ) {
-        const char* const value_c_str = value.c_str();
-        char* end;
-        errno = 0;
-        const double dvalue = strtod(value_c_str, &end);
-        if (end != value_c_str and '\0' == *end and errno != ERANGE) {
-            res = static_cast<T>(dvalue);
-        }
+    double dvalue;
+    if (parse_helper::parse_double(value.data(), value.data() + value.size(), dvalue)) {
+        res = static_cast<T>(dvalue);
     }
     return res;
 }
 
 template <typename T>
-inline T parse(const std::string& value, const T& default_value)
+inline T parse(const nonstd::string_view& value, const T& default_value)
 {
     optional<T> res = parse<T>(value);
     if ( not res ) {
@@ -0,0 +1,324 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_PATH_H_
+#define WRAPIDJSON_PATH_H_
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+
+#include <rapidjson/document.h>
+
+#include "document.h"
+
+namespace wrapidjson {
+
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// One reference token of JSON Pointer
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct PathToken {
+    std::string name;       // unescaped member name
+    size_t      index;      // array index if is_index
+    bool        is_index;
+    bool        wildcard;   // "*" : every member / element
+
+    bool equals(const rapidjson::Value& key) const {
+        return key.GetStringLength() == name.size() and
+            memcmp(key.GetString(), name.data(), name.size()) == 0;
+    }
+
+    bool same(const PathToken& other) const {
+        return wildcard == other.wildcard and name == other.name;
+    }
+
+    /// child value of this token, nullptr if not found ( wildcard is not handled )
+    rapidjson::Value* child(rapidjson::Value& value) const {
+        if (value.IsObject()) {
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                if (equals(it->name)) {
+                    return &it->value;
+                }
+            }
+        } else if (value.IsArray() and is_index and index < value.Size()) {
+            return &value[static_cast<rapidjson::SizeType>(index)];
+        }
+        return nullptr;
+    }
+};
+
+/// RFC 6901 : "" is root, otherwise "/" separated tokens with ~0 ( ~ ) and ~1 ( / ) escapes
+inline std::vector<PathToken> parse_pointer(const string_view& pointer) {
+    std::vector<PathToken> tokens;
+    if (pointer.empty()) {
+        return tokens;
+    }
+    if (pointer[0] != '/') {
+        throw std::runtime_error("JSON pointer must start with '/' : " + std::string(pointer.data(), pointer.size()));
+    }
+    size_t pos = 1;
+    while (true) {
+        size_t end = pointer.find('/', pos);
+        if (end == string_view::npos) {
+            end = pointer.size();
+        }
+        PathToken token{std::string(), 0, false, false};
+        token.name.reserve(end - pos);
+        for (size_t i = pos; i < end; ++i) {
+            char c = pointer[i];
+            if (c == '~') {
+                char e = i + 1 < end ? pointer[i + 1] : '\0';
+                if (e != '0' and e != '1') {
+                    throw std::runtime_error("invalid escape in JSON pointer : " + std::string(pointer.data(), pointer.size()));
+                }
+                token.name.push_back(e == '0' ? '~' : '/');
+                ++i;
+            } else {
+                token.name.push_back(c);
+            }
+        }
+        token.wildcard = (token.name == "*");
+
+        // array index : digits without leading zero
+        const std::string& n = token.name;
+        if (not n.empty() and n.size() <= 18 and (n[0] != '0' or n.size() == 1)) {
+            token.is_index = true;
+            for (char d : n) {
+                if (d < '0' or d > '9') {
+                    token.is_index = false;
+                    break;
+                }
+                token.index = token.index * 10 + static_cast<size_t>(d - '0');
+            }
+        }
+        tokens.push_back(std::move(token));
+        if (end == pointer.size()) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return tokens;
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Compiled JSON Pointer ( parse once, evaluate many times )
+///  - read only : nothing is inserted into Document on missing members
+///  - "*" token matches every member of object and every element of array
+///  - invalid pointer throws std::runtime_error
+///
+///   static const Path price("/items/*/price");
+///   for (auto value : price.select(doc)) { ... }
+///   auto name = Path("/user/name").get(doc);   // optional<ValueRef>
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Path {
+    friend class PathSet;
+public:
+    explicit Path(const string_view& pointer)
+        : pointer_(pointer.data(), pointer.size()), tokens_(detail::parse_pointer(pointer)), wildcard_(false)
+    {
+        for (const auto& token : tokens_) {
+            wildcard_ = wildcard_ or token.wildcard;
+        }
+    }
+
+    /// first match in document order, nullopt if none
+    optional<ValueRef> get(const ValueRef& root) const {
+        optional<ValueRef> result;
+        rapidjson::Value* value = first(*root.value_, 0);
+        if (value != nullptr) {
+            result.emplace(*value, *root.alloc_);
+        }
+        return result;
+    }
+
+    /// every match in document order
+    std::vector<ValueRef> select(const ValueRef& root) const {
+        std::vector<ValueRef> result;
+        collect(*root.value_, 0, *root.alloc_, result);
+        return result;
+    }
+
+    const std::string& str() const { return pointer_; }
+    size_t size() const { return tokens_.size(); }
+    bool has_wildcard() const { return wildcard_; }
+
+private:
+    rapidjson::Value* first(rapidjson::Value& value, size_t depth) const {
+        if (depth == tokens_.size()) {
+            return &value;
+        }
+        const detail::PathToken& token = tokens_[depth];
+        if (not token.wildcard) {
+            rapidjson::Value* child = token.child(value);
+            return child != nullptr ? first(*child, depth + 1) : nullptr;
+        }
+        if (value.IsObject()) {
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                rapidjson::Value* found = first(it->value, depth + 1);
+                if (found != nullptr) {
+                    return found;
+                }
+            }
+        } else if (value.IsArray()) {
+            for (auto it = value.Begin(); it != value.End(); ++it) {
+                rapidjson::Value* found = first(*it, depth + 1);
+                if (found != nullptr) {
+                    return found;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    void collect(rapidjson::Value& value, size_t depth, rapidjson::Document::AllocatorType& alloc,
+            std::vector<ValueRef>& result) const {
+        if (depth == tokens_.size()) {
+            result.emplace_back(value, alloc);
+            return;
+        }
+        const detail::PathToken& token = tokens_[depth];
+        if (not token.wildcard) {
+            rapidjson::Value* child = token.child(value);
+            if (child != nullptr) {
+                collect(*child, depth + 1, alloc, result);
+            }
+        } else if (value.IsObject()) {
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                collect(it->value, depth + 1, alloc, result);
+            }
+        } else if (value.IsArray()) {
+            for (auto it = value.Begin(); it != value.End(); ++it) {
+                collect(*it, depth + 1, alloc, result);
+            }
+        }
+    }
+
+    std::string                     pointer_;
+    std::vector<detail::PathToken>  tokens_;
+    bool                            wildcard_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Batch of paths evaluated in one traversal
+///  - paths are merged into prefix tree, shared prefixes are walked once
+///  - add() returns id, results are indexed by id
+///
+///   PathSet paths;
+///   size_t id = paths.add("/user/id");
+///   size_t name = paths.add("/user/name");
+///   auto values = paths.get(doc);          // values[id], values[name]
+/////////////////////////////////////////////////////////////////////////////////////////////
+class PathSet {
+public:
+    PathSet() : nodes_(1), count_(0) {}
+
+    size_t add(const Path& path) {
+        size_t node = 0;
+        for (const auto& token : path.tokens_) {
+            size_t next = 0;
+            for (size_t child : nodes_[node].children) {
+                if (nodes_[child].token.same(token)) {
+                    next = child;
+                    break;
+                }
+            }
+            if (next == 0) {
+                next = nodes_.size();
+                nodes_.push_back(Node());
+                nodes_.back().token = token;
+                nodes_[node].children.push_back(next);
+            }
+            node = next;
+        }
+        nodes_[node].ids.push_back(count_);
+        return count_++;
+    }
+
+    size_t add(const string_view& pointer) {
+        return add(Path(pointer));
+    }
+
+    size_t size() const { return count_; }
+
+    /// first match of every path ( result[id] )
+    std::vector<optional<ValueRef>> get(const ValueRef& root) const {
+        std::vector<optional<ValueRef>> result(count_);
+        visit(0, *root.value_, [&result, &root](size_t id, rapidjson::Value& value) {
+            if (not result[id]) {
+                result[id].emplace(value, *root.alloc_);
+            }
+        });
+        return result;
+    }
+
+    /// every match of every path ( result[id] )
+    std::vector<std::vector<ValueRef>> select(const ValueRef& root) const {
+        std::vector<std::vector<ValueRef>> result(count_);
+        visit(0, *root.value_, [&result, &root](size_t id, rapidjson::Value& value) {
+            result[id].emplace_back(value, *root.alloc_);
+        });
+        return result;
+    }
+
+private:
+    struct Node {
+        detail::PathToken   token{std::string(), 0, false, false};
+        std::vector<size_t> children;   // node positions
+        std::vector<size_t> ids;        // paths ending here
+    };
+
+    template<typename Visitor>
+    void visit(size_t node, rapidjson::Value& value, const Visitor& visitor) const {
+        const Node& n = nodes_[node];
+        for (size_t id : n.ids) {
+            visitor(id, value);
+        }
+        for (size_t child : n.children) {
+            const detail::PathToken& token = nodes_[child].token;
+            if (not token.wildcard) {
+                rapidjson::Value* next = token.child(value);
+                if (next != nullptr) {
+                    visit(child, *next, visitor);
+                }
+            } else if (value.IsObject()) {
+                for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                    visit(child, it->value, visitor);
+                }
+            } else if (value.IsArray()) {
+                for (auto it = value.Begin(); it != value.End(); ++it) {
+                    visit(child, *it, visitor);
+                }
+            }
+        }
+    }
+
+    std::vector<Node>   nodes_;     // nodes_[0] is root
+    size_t              count_;
+};
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_PATH_H_
@@ -0,0 +1,258 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_PUSH_H_
+#define WRAPIDJSON_PUSH_H_
+
+#include <string>
+#include <cstring>
+
+#include <rapidjson/error/en.h>
+
+#include "document.h"
+#include "simd.h"
+
+namespace wrapidjson {
+
+enum class PushStatus { NEED_MORE, COMPLETE, FAILED };
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Push parser for JSON arriving in fragments ( never blocks, caller owns the socket )
+///  - feed appends a fragment and scans only the new bytes for the end of the value
+///    ( string / escape / nesting state is kept across calls, SIMD kernels of simd.h )
+///  - on the fragment that completes the value, the buffered bytes are moved into
+///    Document and parsed in-situ, so the message is never copied again
+///  - bytes after the value are not taken, consumed() tells where next message starts
+///  - top level number / true / false / null ends at next delimiter, or at finish()
+///
+///   PushParser parser(doc);
+///   while ((n = read(fd, buf, sizeof(buf))) > 0) {
+///       size_t used = 0;
+///       while (used < n and parser.feed(buf + used, n - used) == PushStatus::COMPLETE) {
+///           used += parser.consumed();
+///           handle(doc);
+///           parser.reset();
+///       }
+///   }
+/////////////////////////////////////////////////////////////////////////////////////////////
+class PushParser {
+public:
+    /// max_size : fail once a message buffers more bytes ( 0 is unlimited )
+    explicit PushParser(Document& document, size_t max_size = 0)
+        : document_(&document), max_size_(max_size)
+    {
+        reset();
+    }
+    PushParser(const PushParser&) = delete;
+    PushParser& operator=(const PushParser&) = delete;
+    ~PushParser() = default;
+
+    /// feed next fragment, COMPLETE / FAILED stays until reset()
+    ///  - Flags : rapidjson::ParseFlag for the final parse ( always in-situ on own buffer )
+    template<unsigned Flags = rapidjson::kParseDefaultFlags>
+    PushStatus feed(const char* data, size_t size);
+
+    template<unsigned Flags = rapidjson::kParseDefaultFlags>
+    PushStatus feed(const string_view& data) {
+        return feed<Flags>(data.data(), data.size());
+    }
+
+    /// end of input : completes top level scalar, fails inside unfinished value
+    template<unsigned Flags = rapidjson::kParseDefaultFlags>
+    PushStatus finish();
+
+    /// ready for next message ( Document is left as is )
+    void reset() {
+        buffer_.clear();
+        status_ = PushStatus::NEED_MORE;
+        scan_ = depth_ = consumed_ = 0;
+        started_ = in_string_ = escape_ = scalar_ = false;
+        error_offset_ = 0;
+        error_code_ = rapidjson::kParseErrorNone;
+    }
+
+    PushStatus status() const { return status_; }
+    bool complete() const { return status_ == PushStatus::COMPLETE; }
+    bool failed() const { return status_ == PushStatus::FAILED; }
+
+    /// bytes of last fragment that belong to the value of last feed
+    size_t consumed() const { return consumed_; }
+
+    /// bytes buffered for current message
+    size_t size() const { return buffer_.size(); }
+
+    /// byte offset in current message and rapidjson error code of failure
+    size_t error_offset() const { return error_offset_; }
+    rapidjson::ParseErrorCode error_code() const { return error_code_; }
+    LoadError load_error() const { return LoadError(error_code_, error_offset_); }
+    std::string get_parse_error() const { return load_error().to_string(); }
+
+private:
+    static bool is_space(char c) {
+        return c == ' ' or c == '\t' or c == '\n' or c == '\r';
+    }
+
+    static bool is_delimiter(char c) {
+        return is_space(c) or c == ',' or detail::simd::is_structural(c);
+    }
+
+    /// scan buffer_ from scan_, end position of value or npos
+    size_t scan();
+
+    template<unsigned Flags>
+    PushStatus parse(size_t end);
+
+    PushStatus fail(rapidjson::ParseErrorCode code, size_t offset) {
+        error_code_ = code;
+        error_offset_ = offset;
+        return status_ = PushStatus::FAILED;
+    }
+
+    Document*                   document_;
+    size_t                      max_size_;
+    std::string                 buffer_;
+
+    PushStatus                  status_;
+    size_t                      scan_;          // bytes of buffer_ already scanned
+    size_t                      depth_;
+    size_t                      consumed_;
+    bool                        started_;       // first byte of value seen
+    bool                        in_string_;
+    bool                        escape_;        // previous byte was backslash in string
+    bool                        scalar_;        // top level number / literal
+
+    size_t                      error_offset_;
+    rapidjson::ParseErrorCode   error_code_;
+};
+
+inline size_t PushParser::scan() {
+    const char* data = buffer_.data();
+    const char* end = data + buffer_.size();
+    const char* p = data + scan_;
+    while (p < end) {
+        if (in_string_) {
+            if (escape_) {
+                escape_ = false;
+                ++p;
+                continue;
+            }
+            p = detail::simd::find_quote_or_escape(p, end);
+            if (p == end) {
+                break;
+            }
+            if (*p++ == '\\') {
+                escape_ = true;
+                continue;
+            }
+            in_string_ = false;
+            if (depth_ == 0) {
+                return static_cast<size_t>(p - data);     // top level string
+            }
+            continue;
+        }
+        if (not started_) {
+            if (is_space(*p)) {
+                ++p;
+                continue;
+            }
+            started_ = true;
+            char c = *p++;
+            if (c == '{' or c == '[') {
+                depth_ = 1;
+            } else if (c == '"') {
+                in_string_ = true;
+            } else if (c == '}' or c == ']') {
+                return static_cast<size_t>(p - data);     // let parse report it
+            } else {
+                scalar_ = true;
+            }
+            continue;
+        }
+        if (scalar_) {
+            while (p < end and not is_delimiter(*p)) {
+                ++p;
+            }
+            if (p < end) {
+                return static_cast<size_t>(p - data);
+            }
+            break;
+        }
+        p = detail::simd::find_structural(p, end);
+        if (p == end) {
+            break;
+        }
+        char c = *p++;
+        if (c == '"') {
+            in_string_ = true;
+        } else if (c == '{' or c == '[') {
+            ++depth_;
+        } else if (--depth_ == 0) {
+            return static_cast<size_t>(p - data);
+        }
+    }
+    scan_ = buffer_.size();
+    return std::string::npos;
+}
+
+template<unsigned Flags>
+inline PushStatus PushParser::parse(size_t end) {
+    buffer_.resize(end);
+    bool ok = document_->load_from_buffer_insitu<Flags>(std::move(buffer_));
+    buffer_.clear();
+    scan_ = 0;
+    if (not ok) {
+        return fail(document_->get_document().GetParseError(), document_->get_document().GetErrorOffset());
+    }
+    return status_ = PushStatus::COMPLETE;
+}
+
+template<unsigned Flags>
+inline PushStatus PushParser::feed(const char* data, size_t size) {
+    consumed_ = 0;
+    if (status_ != PushStatus::NEED_MORE) {
+        return status_;
+    }
+    size_t begin = buffer_.size();
+    buffer_.append(data, size);
+    size_t end = scan();
+    if (end == std::string::npos) {
+        consumed_ = size;
+        if (max_size_ != 0 and buffer_.size() > max_size_) {
+            return fail(rapidjson::kParseErrorTermination, max_size_);
+        }
+        return status_;
+    }
+    consumed_ = end - begin;
+    return parse<Flags>(end);
+}
+
+template<unsigned Flags>
+inline PushStatus PushParser::finish() {
+    consumed_ = 0;
+    if (status_ != PushStatus::NEED_MORE) {
+        return status_;
+    }
+    return parse<Flags>(buffer_.size());     // scalar completes, anything else reports its error
+}
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_PUSH_H_
@@ -0,0 +1,252 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_READER_H_
+#define WRAPIDJSON_READER_H_
+
+#include <string>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include "simd.h"
+
+#include <rapidjson/reader.h>
+#include <rapidjson/filereadstream.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/encodedstream.h>
+#include <rapidjson/error/en.h>
+
+#include "value_ref.h"
+#include "stream.h"
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Return value of ReaderHandler callbacks
+///  - CONTINUE : read next event
+///  - SKIP     : on_key skips member value, on_start_* skips rest of container
+///  - STOP     : stop reading ( Reader::stopped() is true )
+/////////////////////////////////////////////////////////////////////////////////////////////
+enum class ReadAction { CONTINUE, SKIP, STOP };
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Streaming event handler ( override needed events only )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ReaderHandler {
+public:
+    virtual ~ReaderHandler() = default;
+
+    /// null, bool, number, string. value and its string are valid only in callback
+    virtual ReadAction on_value(const ValueRef& value) {
+        (void)value;
+        return ReadAction::CONTINUE;
+    }
+    /// member name. key is valid only in callback
+    virtual ReadAction on_key(const string_view& key) {
+        (void)key;
+        return ReadAction::CONTINUE;
+    }
+    virtual ReadAction on_start_object() { return ReadAction::CONTINUE; }
+    virtual ReadAction on_end_object(size_t member_count) {
+        (void)member_count;
+        return ReadAction::CONTINUE;
+    }
+    virtual ReadAction on_start_array() { return ReadAction::CONTINUE; }
+    virtual ReadAction on_end_array(size_t element_count) {
+        (void)element_count;
+        return ReadAction::CONTINUE;
+    }
+};
+
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// rapidjson handler dispatching to ReaderHandler, and skipping subtrees
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ReaderAdapter {
+public:
+    explicit ReaderAdapter(ReaderHandler& handler)
+        : handler_(handler), skip_depth_(0), skip_next_(false) {}
+
+    bool Null() { value_.SetNull(); return Scalar(); }
+    bool Bool(bool b) { value_.SetBool(b); return Scalar(); }
+    bool Int(int i) { value_.SetInt(i); return Scalar(); }
+    bool Uint(unsigned u) { value_.SetUint(u); return Scalar(); }
+    bool Int64(int64_t i) { value_.SetInt64(i); return Scalar(); }
+    bool Uint64(uint64_t u) { value_.SetUint64(u); return Scalar(); }
+    bool Double(double d) { value_.SetDouble(d); return Scalar(); }
+    bool RawNumber(const char* str, rapidjson::SizeType length, bool) {
+        value_.SetString(rapidjson::StringRef(str, length));
+        return Scalar();
+    }
+    bool String(const char* str, rapidjson::SizeType length, bool) {
+        value_.SetString(rapidjson::StringRef(str, length));
+        return Scalar();
+    }
+
+    bool StartObject() { return Start(true); }
+    bool Key(const char* str, rapidjson::SizeType length, bool) {
+        if (skip_depth_ > 0) {
+            return true;
+        }
+        ReadAction action = handler_.on_key(string_view(str, length));
+        skip_next_ = (action == ReadAction::SKIP);
+        return action != ReadAction::STOP;
+    }
+    bool EndObject(rapidjson::SizeType count) { return End(true, count); }
+    bool StartArray() { return Start(false); }
+    bool EndArray(rapidjson::SizeType count) { return End(false, count); }
+
+private:
+    bool Scalar() {
+        if (skip_depth_ > 0) {
+            return true;
+        } else if (skip_next_) {
+            skip_next_ = false;
+            return true;
+        }
+        return handler_.on_value(ValueRef(value_, alloc_)) != ReadAction::STOP;
+    }
+
+    bool Start(bool object) {
+        if (skip_depth_ > 0) {
+            ++skip_depth_;
+            return true;
+        } else if (skip_next_) {
+            skip_next_ = false;
+            skip_depth_ = 1;
+            return true;
+        }
+        ReadAction action = object ? handler_.on_start_object() : handler_.on_start_array();
+        if (action == ReadAction::SKIP) {
+            skip_depth_ = 1;
+        }
+        return action != ReadAction::STOP;
+    }
+
+    bool End(bool object, rapidjson::SizeType count) {
+        if (skip_depth_ > 0) {
+            --skip_depth_;
+            return true;
+        }
+        ReadAction action = object ? handler_.on_end_object(count) : handler_.on_end_array(count);
+        return action != ReadAction::STOP;
+    }
+
+    ReaderHandler&                      handler_;
+    size_t                              skip_depth_;
+    bool                                skip_next_;
+    rapidjson::Value                    value_;     // scratch value for on_value
+    rapidjson::Document::AllocatorType  alloc_;
+};
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Streaming reader ( memory is O(depth), DOM is not built )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Reader {
+    static const size_t BUFFER_SIZE = 65536;
+public:
+    /// validate_utf8 : reject invalid UTF-8 ( buffers are pre-scanned by SIMD kernels,
+    ///                 files and streams use rapidjson encoding validation )
+    explicit Reader(bool validate_utf8 = false) : validate_utf8_(validate_utf8) {}
+    ~Reader() = default;
+
+    /// read JSON data
+    bool read_from_file(const std::string& path, ReaderHandler& handler);
+    bool read_from_buffer(const string_view& buffer, ReaderHandler& handler);
+    bool read_from_stream(std::istream& is, ReaderHandler& handler,
+            size_t buffer_size = IStream::DEFAULT_BUFFER_SIZE);
+
+    /// handler returned ReadAction::STOP
+    bool stopped() const { return result_.Code() == rapidjson::kParseErrorTermination; }
+    /// errno when read_from_file could not open the file ( 0 otherwise )
+    int io_error() const { return io_error_; }
+
+    std::string get_read_error() const;
+
+private:
+    template<typename InputStream>
+    bool read(InputStream& is, ReaderHandler& handler, bool validate_utf8) {
+        detail::ReaderAdapter adapter(handler);
+        rapidjson::Reader reader;
+        io_error_ = 0;
+        if (validate_utf8) {
+            result_ = reader.Parse<rapidjson::kParseValidateEncodingFlag>(is, adapter);
+        } else {
+            result_ = reader.Parse<0>(is, adapter);
+        }
+        return not result_.IsError();
+    }
+
+    bool                    validate_utf8_;
+    rapidjson::ParseResult  result_;
+    int                     io_error_ = 0;
+};
+
+inline bool Reader::read_from_file(const std::string& path, ReaderHandler& handler) {
+    FILE* fp = fopen(path.c_str(), "r");
+    if (fp == nullptr) {
+        io_error_ = errno != 0 ? errno : EIO;
+        result_.Clear();
+        return false;
+    }
+
+    char    readBuffer[BUFFER_SIZE];
+    rapidjson::FileReadStream is(fp, readBuffer, BUFFER_SIZE);
+    bool ret = read(is, handler, validate_utf8_);
+    fclose(fp);
+    return ret;
+}
+
+inline bool Reader::read_from_buffer(const string_view& buffer, ReaderHandler& handler) {
+    if (validate_utf8_) {
+        size_t invalid = detail::simd::find_invalid_utf8(buffer.data(), buffer.size());
+        if (invalid != buffer.size()) {
+            result_.Set(rapidjson::kParseErrorStringInvalidEncoding, invalid);
+            io_error_ = 0;
+            return false;
+        }
+    }
+    rapidjson::MemoryStream ms(buffer.data(), buffer.size());
+    rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream> is(ms);
+    return read(is, handler, false);
+}
+
+inline bool Reader::read_from_stream(std::istream& is, ReaderHandler& handler, size_t buffer_size) {
+    IStream is_wrapper(is, buffer_size);
+    return read(is_wrapper, handler, validate_utf8_);
+}
+
+inline std::string Reader::get_read_error() const {
+    if (io_error_ != 0) {
+        return detail::format("Error io[%d]: %s", io_error_, std::strerror(io_error_));
+    }
+    return detail::format("Error offset[%u]: %s",
+            (unsigned)result_.Offset(),
+            rapidjson::GetParseError_En(result_.Code()));
+}
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_READER_H_
@@ -0,0 +1,664 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_SERIALIZER_H_
+#define WRAPIDJSON_SERIALIZER_H_
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <bitset>
+#include <memory>
+#include <limits>
+#include <istream>
+#include <type_traits>
+
+#include <rapidjson/reader.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/error/en.h>
+
+#include "binding.h"
+#include "format.h"
+#include "stream.h"
+#include "writer.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Opt-in serialization for user structs ( no DOM on either side )
+///
+///   struct User { int id; std::string name; nonstd::optional<std::string> email; };
+///   WRAPIDJSON_BIND(User, id, name, email)      // JSON key = member name
+///
+///   WRAPIDJSON_BIND_FIELDS(User,                // custom keys / required flags
+///       wrapidjson::field("user_id", &User::id), wrapidjson::field("name", &User::name),
+///       wrapidjson::field("email", &User::email, false))
+///
+/// use at namespace scope of the struct, members must be public.
+/// WRAPIDJSON_BIND : nonstd::optional members are not required, every other member is.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#define WRAPIDJSON_BIND_FIELDS(Type, ...)                                                   \
+    inline const decltype(::wrapidjson::make_binding(__VA_ARGS__))&                        \
+    wrapidjson_binding(const Type*) {                                                       \
+        static const auto binding = ::wrapidjson::make_binding(__VA_ARGS__);                \
+        return binding;                                                                     \
+    }
+
+#define WRAPIDJSON_BIND(Type, ...) \
+    WRAPIDJSON_BIND_FIELDS(Type, WRAPIDJSON_PP_FIELDS(Type, __VA_ARGS__))
+
+// up to 24 members
+#define WRAPIDJSON_PP_EXPAND(x) x
+#define WRAPIDJSON_PP_CAT(a, b) WRAPIDJSON_PP_CAT_(a, b)
+#define WRAPIDJSON_PP_CAT_(a, b) a##b
+#define WRAPIDJSON_PP_FIELD(Type, m) ::wrapidjson::detail::auto_field(#m, &Type::m)
+#define WRAPIDJSON_PP_FIELDS(Type, ...) \
+    WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_CAT(WRAPIDJSON_PP_FIELDS_, WRAPIDJSON_PP_COUNT(__VA_ARGS__))(Type, __VA_ARGS__))
+#define WRAPIDJSON_PP_COUNT(...) \
+    WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_COUNT_(__VA_ARGS__, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define WRAPIDJSON_PP_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, N, ...) N
+#define WRAPIDJSON_PP_FIELDS_1(T, m) WRAPIDJSON_PP_FIELD(T, m)
+#define WRAPIDJSON_PP_FIELDS_2(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_1(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_3(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_2(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_4(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_3(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_5(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_4(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_6(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_5(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_7(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_6(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_8(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_7(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_9(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_8(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_10(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_9(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_11(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_10(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_12(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_11(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_13(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_12(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_14(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_13(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_15(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_14(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_16(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_15(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_17(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_16(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_18(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_17(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_19(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_18(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_20(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_19(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_21(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_20(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_22(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_21(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_23(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_22(T, __VA_ARGS__))
+#define WRAPIDJSON_PP_FIELDS_24(T, m, ...) WRAPIDJSON_PP_FIELD(T, m), WRAPIDJSON_PP_EXPAND(WRAPIDJSON_PP_FIELDS_23(T, __VA_ARGS__))
+
+namespace wrapidjson {
+namespace detail {
+
+/// field of WRAPIDJSON_BIND : required unless member is optional
+template<size_t N, typename T, typename M>
+constexpr Field<T, M> auto_field(const char (&name)[N], M T::* member) {
+    return Field<T, M>{Key(name), member, not is_optional<M>::value};
+}
+
+namespace sax {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SAX event sink for one JSON value ( stack frame of Decoder )
+///  - scalar / start_* : false on type mismatch
+///  - member / element : sink for next value, nullptr skips it
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Sink {
+public:
+    virtual ~Sink() = default;
+
+    virtual bool null_value() { return false; }
+    virtual bool bool_value(bool) { return false; }
+    virtual bool int64_value(int64_t) { return false; }
+    virtual bool uint64_value(uint64_t) { return false; }
+    virtual bool double_value(double) { return false; }
+    virtual bool string_value(const char*, size_t) { return false; }
+
+    virtual bool start_object() { return false; }
+    virtual bool start_array() { return false; }
+    virtual Sink* member(const char*, size_t) { return nullptr; }
+    /// null value of current member is skipped ( not required field )
+    virtual bool member_nullable() const { return false; }
+    virtual Sink* element() { return nullptr; }
+    /// current member / element was invalid, drop it
+    virtual void discard() {}
+    /// container end, appends names of missing required members
+    virtual void end(std::vector<std::string>&) {}
+};
+
+/// Sink for M, same rules as Codec<M>
+template<typename M, typename Enable = void>
+class TypedSink;
+
+template<>
+class TypedSink<bool> : public Sink {
+public:
+    void reset(bool* out) { out_ = out; }
+    bool bool_value(bool b) override { *out_ = b; return true; }
+private:
+    bool* out_ = nullptr;
+};
+
+template<>
+class TypedSink<char> : public Sink {
+public:
+    void reset(char* out) { out_ = out; }
+    bool string_value(const char* str, size_t length) override {
+        if (length != 1) {
+            return false;
+        }
+        *out_ = str[0];
+        return true;
+    }
+private:
+    char* out_ = nullptr;
+};
+
+template<typename M>
+class TypedSink<M, enable_if_t<std::is_integral<M>::value and
+        not std::is_same<M, bool>::value and not std::is_same<M, char>::value>> : public Sink {
+public:
+    void reset(M* out) { out_ = out; }
+    bool int64_value(int64_t v) override {
+        if (v >= 0) {
+            return uint64_value(static_cast<uint64_t>(v));
+        }
+        if (std::is_unsigned<M>::value or v < static_cast<int64_t>(std::numeric_limits<M>::min())) {
+            return false;
+        }
+        *out_ = static_cast<M>(v);
+        return true;
+    }
+    bool uint64_value(uint64_t v) override {
+        if (v > static_cast<uint64_t>(std::numeric_limits<M>::max())) {
+            return false;
+        }
+        *out_ = static_cast<M>(v);
+        return true;
+    }
+private:
+    M* out_ = nullptr;
+};
+
+template<typename M>
+class TypedSink<M, enable_if_t<std::is_floating_point<M>::value>> : public Sink {
+public:
+    void reset(M* out) { out_ = out; }
+    bool int64_value(int64_t v) override { *out_ = static_cast<M>(v); return true; }
+    bool uint64_value(uint64_t v) override { *out_ = static_cast<M>(v); return true; }
+    bool double_value(double v) override { *out_ = static_cast<M>(v); return true; }
+private:
+    M* out_ = nullptr;
+};
+
+template<typename M>
+class TypedSink<M, enable_if_t<is_string<M>::value>> : public Sink {
+public:
+    void reset(M* out) { out_ = out; }
+    bool string_value(const char* str, size_t length) override { out_->assign(str, length); return true; }
+private:
+    M* out_ = nullptr;
+};
+
+/// null is empty optional, scalars are decoded into temporary first
+template<typename M>
+class TypedSink<nonstd::optional<M>> : public Sink {
+public:
+    void reset(nonstd::optional<M>* out) { out_ = out; }
+
+    bool null_value() override { *out_ = nonstd::nullopt; return true; }
+    bool bool_value(bool v) override { return scalar(&Sink::bool_value, v); }
+    bool int64_value(int64_t v) override { return scalar(&Sink::int64_value, v); }
+    bool uint64_value(uint64_t v) override { return scalar(&Sink::uint64_value, v); }
+    bool double_value(double v) override { return scalar(&Sink::double_value, v); }
+    bool string_value(const char* str, size_t length) override {
+        M item;
+        if (not bind(&item).string_value(str, length)) {
+            return false;
+        }
+        *out_ = std::move(item);
+        return true;
+    }
+
+    bool start_object() override { out_->emplace(); return bind(&**out_).start_object(); }
+    bool start_array() override { out_->emplace(); return bind(&**out_).start_array(); }
+    Sink* member(const char* name, size_t length) override { return inner_->member(name, length); }
+    bool member_nullable() const override { return inner_->member_nullable(); }
+    Sink* element() override { return inner_->element(); }
+    void discard() override { inner_->discard(); }
+    void end(std::vector<std::string>& missing) override { inner_->end(missing); }
+
+private:
+    TypedSink<M>& bind(M* out) {
+        if (not inner_) {
+            inner_.reset(new TypedSink<M>());
+        }
+        inner_->reset(out);
+        return *inner_;
+    }
+
+    template<typename V>
+    bool scalar(bool (Sink::*set)(V), V v) {
+        M item;
+        if (not (bind(&item).*set)(v)) {
+            return false;
+        }
+        *out_ = std::move(item);
+        return true;
+    }
+
+    nonstd::optional<M>*            out_ = nullptr;
+    std::unique_ptr<TypedSink<M>>   inner_;
+};
+
+/// elements are decoded into one reused item, then moved to the end of container
+template<typename C>
+class TypedSink<C, enable_if_t<is_sequence<C>::value>> : public Sink {
+    using Item = typename C::value_type;
+public:
+    void reset(C* out) { out_ = out; }
+
+    bool start_array() override {
+        out_->clear();
+        pending_ = false;
+        return true;
+    }
+    Sink* element() override {
+        flush();
+        item_ = Item();
+        pending_ = true;
+        if (not child_) {
+            child_.reset(new TypedSink<Item>());
+        }
+        child_->reset(&item_);
+        return child_.get();
+    }
+    void discard() override { pending_ = false; }
+    void end(std::vector<std::string>&) override { flush(); }
+
+private:
+    void flush() {
+        if (pending_) {
+            out_->insert(out_->end(), std::move(item_));
+            pending_ = false;
+        }
+    }
+
+    C*                                  out_ = nullptr;
+    Item                                item_;
+    bool                                pending_ = false;
+    std::unique_ptr<TypedSink<Item>>    child_;
+};
+
+template<typename C>
+class TypedSink<C, enable_if_t<is_string_map<C>::value>> : public Sink {
+    using Item = typename C::mapped_type;
+public:
+    void reset(C* out) { out_ = out; }
+
+    bool start_object() override {
+        out_->clear();
+        pending_ = false;
+        return true;
+    }
+    Sink* member(const char* name, size_t length) override {
+        flush();
+        key_.assign(name, length);
+        item_ = Item();
+        pending_ = true;
+        if (not child_) {
+            child_.reset(new TypedSink<Item>());
+        }
+        child_->reset(&item_);
+        return child_.get();
+    }
+    void discard() override { pending_ = false; }
+    void end(std::vector<std::string>&) override { flush(); }
+
+private:
+    void flush() {
+        if (pending_) {
+            out_->emplace(std::move(key_), std::move(item_));
+            pending_ = false;
+        }
+    }
+
+    C*                                  out_ = nullptr;
+    std::string                         key_;
+    Item                                item_;
+    bool                                pending_ = false;
+    std::unique_ptr<TypedSink<Item>>    child_;
+};
+
+/// struct fields by Binding ( same rules as Binding::decode )
+template<typename B>
+class BindingSink;
+
+template<typename T, typename... Ms>
+class BindingSink<Binding<T, Ms...>> : public Sink {
+    static const size_t FIELD_COUNT = sizeof...(Ms);
+public:
+    explicit BindingSink(const Binding<T, Ms...>& binding) : binding_(binding) {}
+
+    void reset(T* out) { out_ = out; }
+
+    bool start_object() override {
+        seen_.reset();
+        current_ = FIELD_COUNT;
+        return true;
+    }
+    Sink* member(const char* name, size_t length) override {
+        current_ = binding_.find_field(name, length);
+        if (current_ == FIELD_COUNT or seen_[current_]) {
+            current_ = FIELD_COUNT;     // unknown or duplicate ( first member is used )
+            return nullptr;
+        }
+        seen_[current_] = true;
+        return child_at<0>(current_);
+    }
+    bool member_nullable() const override {
+        return current_ != FIELD_COUNT and not binding_.required(current_);
+    }
+    void end(std::vector<std::string>& missing) override {
+        for (size_t i = 0; i < FIELD_COUNT; ++i) {
+            if (not seen_[i] and binding_.required(i)) {
+                missing.push_back(binding_.key(i).str());
+            }
+        }
+    }
+
+private:
+    template<size_t I>
+    enable_if_t<(I < FIELD_COUNT), Sink*> child_at(size_t i) {
+        if (i == I) {
+            using M = typename std::tuple_element<I, std::tuple<Ms...>>::type;
+            auto& child = std::get<I>(children_);
+            if (not child) {
+                child.reset(new TypedSink<M>());
+            }
+            child->reset(&(out_->*(std::get<I>(binding_.fields()).member)));
+            return child.get();
+        }
+        return child_at<I + 1>(i);
+    }
+
+    template<size_t I>
+    enable_if_t<(I == FIELD_COUNT), Sink*> child_at(size_t) {
+        return nullptr;
+    }
+
+    const Binding<T, Ms...>&                        binding_;
+    T*                                              out_ = nullptr;
+    size_t                                          current_ = FIELD_COUNT;
+    std::bitset<FIELD_COUNT == 0 ? 1 : FIELD_COUNT> seen_;
+    std::tuple<std::unique_ptr<TypedSink<Ms>>...>   children_;  // created on first use
+};
+
+template<typename T>
+using binding_type = typename std::decay<decltype(wrapidjson_binding(static_cast<const T*>(nullptr)))>::type;
+
+template<typename T>
+class TypedSink<T, enable_if_t<has_binding<T>::value>> : public BindingSink<binding_type<T>> {
+public:
+    TypedSink() : BindingSink<binding_type<T>>(wrapidjson_binding(static_cast<const T*>(nullptr))) {}
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// rapidjson SAX handler driving Sink stack
+///  - unknown members and values of mismatched type are skipped, parse goes on
+///  - invalid / missing names are paths from root : "user.id", "items[2].price"
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Decoder : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Decoder> {
+public:
+    explicit Decoder(Sink& root) : root_(&root) {}
+
+    bool Null() {
+        if (skip_ > 0) {
+            return true;
+        }
+        bool nullable = not stack_.empty() and not stack_.back().array and member_nullable_;
+        Sink* sink = target();
+        if (sink != nullptr and not nullable and not sink->null_value()) {
+            invalid();
+        }
+        return true;
+    }
+    bool Bool(bool b) { return scalar(&Sink::bool_value, b); }
+    bool Int(int i) { return scalar(&Sink::int64_value, static_cast<int64_t>(i)); }
+    bool Uint(unsigned u) { return scalar(&Sink::uint64_value, static_cast<uint64_t>(u)); }
+    bool Int64(int64_t i) { return scalar(&Sink::int64_value, i); }
+    bool Uint64(uint64_t u) { return scalar(&Sink::uint64_value, u); }
+    bool Double(double d) { return scalar(&Sink::double_value, d); }
+    bool String(const char* str, rapidjson::SizeType length, bool) {
+        if (skip_ > 0) {
+            return true;
+        }
+        Sink* sink = target();
+        if (sink != nullptr and not sink->string_value(str, length)) {
+            invalid();
+        }
+        return true;
+    }
+
+    bool StartObject() { return start(false); }
+    bool Key(const char* str, rapidjson::SizeType length, bool) {
+        if (skip_ > 0) {
+            return true;
+        }
+        Frame& frame = stack_.back();
+        key_.assign(str, length);
+        member_ = frame.sink->member(str, length);
+        member_nullable_ = frame.sink->member_nullable();
+        return true;
+    }
+    bool EndObject(rapidjson::SizeType) { return end(); }
+    bool StartArray() { return start(true); }
+    bool EndArray(rapidjson::SizeType) { return end(); }
+
+    BindResult& result() { return result_; }
+
+private:
+    struct Frame {
+        Sink*       sink;
+        bool        array;
+        size_t      index;      // next element
+        std::string name;       // label in parent, empty for root
+    };
+
+    template<typename V>
+    bool scalar(bool (Sink::*set)(V), V v) {
+        if (skip_ > 0) {
+            return true;
+        }
+        Sink* sink = target();
+        if (sink != nullptr and not (sink->*set)(v)) {
+            invalid();
+        }
+        return true;
+    }
+
+    bool start(bool array) {
+        if (skip_ > 0) {
+            ++skip_;
+            return true;
+        }
+        std::string name = stack_.empty() ? std::string() : label(stack_.back());
+        Sink* sink = target();
+        if (sink == nullptr) {
+            skip_ = 1;
+            return true;
+        }
+        if (not (array ? sink->start_array() : sink->start_object())) {
+            invalid();
+            skip_ = 1;
+            return true;
+        }
+        stack_.push_back(Frame{sink, array, 0, std::move(name)});
+        return true;
+    }
+
+    bool end() {
+        if (skip_ > 0) {
+            --skip_;
+            return true;
+        }
+        std::string prefix = path(false);
+        size_t first = result_.missing.size();
+        stack_.back().sink->end(result_.missing);
+        for (size_t i = first; i < result_.missing.size() and not prefix.empty(); ++i) {
+            result_.missing[i] = prefix + "." + result_.missing[i];
+        }
+        stack_.pop_back();
+        return true;
+    }
+
+    /// sink for next value ( root once, then element of array or value of last key )
+    Sink* target() {
+        if (stack_.empty()) {
+            Sink* root = root_;
+            root_ = nullptr;
+            return root;
+        }
+        Frame& frame = stack_.back();
+        if (frame.array) {
+            ++frame.index;
+            return frame.sink->element();
+        }
+        return member_;
+    }
+
+    /// current value in frame : last key or last element
+    std::string label(const Frame& frame) const {
+        return frame.array ? "[" + std::to_string(frame.index) + "]" : key_;
+    }
+
+    std::string path(bool current) const {
+        std::string res;
+        for (const Frame& frame : stack_) {
+            append(res, frame.name);
+        }
+        if (current and not stack_.empty()) {
+            const Frame& top = stack_.back();
+            append(res, top.array ? "[" + std::to_string(top.index - 1) + "]" : key_);
+        }
+        return res;
+    }
+
+    static void append(std::string& path, const std::string& name) {
+        if (not path.empty() and not name.empty() and name[0] != '[') {
+            path += '.';
+        }
+        path += name;
+    }
+
+    void invalid() {
+        result_.invalid.push_back(path(true));
+        if (not stack_.empty()) {
+            stack_.back().sink->discard();
+        }
+    }
+
+    Sink*               root_;
+    std::vector<Frame>  stack_;
+    std::string         key_;                       // last member name
+    Sink*               member_ = nullptr;          // sink for value of last key
+    bool                member_nullable_ = false;
+    size_t              skip_ = 0;                  // depth in skipped container
+    BindResult          result_;
+};
+
+template<unsigned Flags, typename InputStream>
+inline BindResult decode(InputStream& is, Sink& sink) {
+    Decoder decoder(sink);
+    rapidjson::Reader reader;
+    rapidjson::ParseResult res = reader.Parse<load_flags<Flags>::value>(is, decoder);
+    BindResult result = std::move(decoder.result());
+    if (res.IsError()) {
+        result.error = detail::format("Error offset[%u]: %s",
+                (unsigned)res.Offset(), rapidjson::GetParseError_En(res.Code()));
+    }
+    return result;
+}
+
+template<unsigned Flags, typename SinkType, typename T>
+inline BindResult decode_buffer(const string_view& json, SinkType& sink, T& out) {
+    sink.reset(&out);
+    rapidjson::MemoryStream ms(json.data(), json.size());
+    rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream> is(ms);
+    return decode<Flags>(is, sink);
+}
+
+} // namespace sax
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// write value straight to rapidjson Writer / PrettyWriter ( no DOM )
+///  - WRAPIDJSON_BIND structs, arithmetic, std::string, optional, sequences, string keyed maps
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T, typename Writer>
+inline bool write_json(const T& value, Writer& writer) {
+    return detail::Codec<T>::encode(writer, value);
+}
+
+/// append to caller buffer, reserve it once and reuse across messages
+template<typename T>
+inline bool append_json(const T& value, std::string& buffer, bool pretty = false) {
+    detail::StringOStream os(buffer);
+    if (pretty) {
+        rapidjson::PrettyWriter<detail::StringOStream> writer(os);
+        return write_json(value, writer);
+    }
+    rapidjson::Writer<detail::StringOStream> writer(os);
+    return write_json(value, writer);
+}
+
+template<typename T>
+inline std::string to_json(const T& value, bool pretty = false) {
+    std::string buffer;
+    append_json(value, buffer, pretty);
+    return buffer;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// parse JSON text into value by SAX ( no DOM, memory is O(depth) )
+///  - Flags : rapidjson::ParseFlag, kParseInsituFlag is rejected at compile time
+///  - result.error is set on malformed JSON, value may be partially filled
+///  - missing / invalid follow Binding::decode, names are paths "user.id", "items[1]"
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<unsigned Flags = rapidjson::kParseDefaultFlags, typename T>
+inline BindResult from_json(const string_view& json, T& out) {
+    detail::sax::TypedSink<T> sink;
+    return detail::sax::decode_buffer<Flags>(json, sink, out);
+}
+
+template<unsigned Flags = rapidjson::kParseDefaultFlags, typename T>
+inline BindResult from_json(std::istream& is, T& out, size_t buffer_size = IStream::DEFAULT_BUFFER_SIZE) {
+    detail::sax::TypedSink<T> sink;
+    sink.reset(&out);
+    IStream is_wrapper(is, buffer_size);
+    return detail::sax::decode<Flags>(is_wrapper, sink);
+}
+
+/// struct of make_binding ( without WRAPIDJSON_BIND )
+template<unsigned Flags = rapidjson::kParseDefaultFlags, typename T, typename... Ms>
+inline BindResult from_json(const string_view& json, T& out, const Binding<T, Ms...>& binding) {
+    detail::sax::BindingSink<Binding<T, Ms...>> sink(binding);
+    return detail::sax::decode_buffer<Flags>(json, sink, out);
+}
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_SERIALIZER_H_
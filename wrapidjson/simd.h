@@ -0,0 +1,343 @@
+#ifndef WRAPIDJSON_SIMD_H_
+#define WRAPIDJSON_SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// rapidjson's own reader SIMD ( RAPIDJSON_SSE2 / SSE42 / NEON ) is not set here, it has to be
+// the same in every translation unit : cmake -DWRAPIDJSON_RAPIDJSON_SIMD=SSE42 or your build flags
+
+// wrapidjson kernels : SSE2 baseline and AVX2 by runtime dispatch on x86-64, NEON on aarch64
+#if defined(__x86_64__) || defined(_M_X64)
+#  define WRAPIDJSON_SIMD_SSE2 1
+#  include <emmintrin.h>
+#  if defined(__GNUC__) || defined(__clang__)
+#    define WRAPIDJSON_SIMD_AVX2 1
+#    include <immintrin.h>
+#  endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#  define WRAPIDJSON_SIMD_NEON 1
+#  include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Byte scanning kernels for first stage of parsing
+///  - ascii prefix ( UTF-8 validation skips ASCII runs by vector, checks the rest by table )
+///  - next quote / backslash inside string
+///  - next structural character ( " { } [ ] ) while skipping subtrees
+/// kernel set is selected once on first use ( kernels().name )
+/////////////////////////////////////////////////////////////////////////////////////////////
+namespace simd {
+
+inline unsigned ctz32(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+inline bool is_structural(char c) {
+    return c == '"' or c == '{' or c == '}' or c == '[' or c == ']';
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// scalar
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline size_t ascii_prefix_scalar(const char* s, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v;
+        memcpy(&v, s + i, sizeof(v));
+        if (v & 0x8080808080808080ull) {
+            break;
+        }
+    }
+    while (i < n and static_cast<unsigned char>(s[i]) < 0x80) {
+        ++i;
+    }
+    return i;
+}
+
+inline const char* find_quote_or_escape_scalar(const char* p, const char* end) {
+    while (p < end and *p != '"' and *p != '\\') {
+        ++p;
+    }
+    return p;
+}
+
+inline const char* find_structural_scalar(const char* p, const char* end) {
+    while (p < end and not is_structural(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+#if WRAPIDJSON_SIMD_SSE2
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SSE2 ( 16 bytes )
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline size_t ascii_prefix_sse2(const char* s, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(v));
+        if (mask != 0) {
+            return i + ctz32(mask);
+        }
+    }
+    return i + ascii_prefix_scalar(s + i, n - i);
+}
+
+inline const char* find_quote_or_escape_sse2(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i escape = _mm_set1_epi8('\\');
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, escape));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        if (mask != 0) {
+            return p + ctz32(mask);
+        }
+    }
+    return find_quote_or_escape_scalar(p, end);
+}
+
+inline const char* find_structural_sse2(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i open = _mm_set1_epi8('[');
+    const __m128i close = _mm_set1_epi8(']');
+    const __m128i open_brace = _mm_set1_epi8('{');
+    const __m128i close_brace = _mm_set1_epi8('}');
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hit = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, open)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, close),
+                _mm_or_si128(_mm_cmpeq_epi8(v, open_brace), _mm_cmpeq_epi8(v, close_brace))));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        if (mask != 0) {
+            return p + ctz32(mask);
+        }
+    }
+    return find_structural_scalar(p, end);
+}
+#endif
+
+#if WRAPIDJSON_SIMD_AVX2
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// AVX2 ( 32 bytes, compiled for avx2 target only, called after cpu check )
+/////////////////////////////////////////////////////////////////////////////////////////////
+__attribute__((target("avx2")))
+inline size_t ascii_prefix_avx2(const char* s, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(v));
+        if (mask != 0) {
+            return i + ctz32(mask);
+        }
+    }
+    return i + ascii_prefix_sse2(s + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline const char* find_quote_or_escape_avx2(const char* p, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i escape = _mm256_set1_epi8('\\');
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, escape));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask != 0) {
+            return p + ctz32(mask);
+        }
+    }
+    return find_quote_or_escape_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+inline const char* find_structural_avx2(const char* p, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i open = _mm256_set1_epi8('[');
+    const __m256i close = _mm256_set1_epi8(']');
+    const __m256i open_brace = _mm256_set1_epi8('{');
+    const __m256i close_brace = _mm256_set1_epi8('}');
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hit = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, open)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, close),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, open_brace), _mm256_cmpeq_epi8(v, close_brace))));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask != 0) {
+            return p + ctz32(mask);
+        }
+    }
+    return find_structural_sse2(p, end);
+}
+#endif
+
+#if WRAPIDJSON_SIMD_NEON
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// NEON ( 16 bytes, 4 bit per byte mask )
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline uint64_t neon_mask(uint8x16_t hit) {
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(hit), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+
+inline unsigned neon_first(uint64_t mask) {
+    return static_cast<unsigned>(__builtin_ctzll(mask)) >> 2;
+}
+
+inline size_t ascii_prefix_neon(const char* s, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(s + i));
+        uint64_t mask = neon_mask(vcgeq_u8(v, vdupq_n_u8(0x80)));
+        if (mask != 0) {
+            return i + neon_first(mask);
+        }
+    }
+    return i + ascii_prefix_scalar(s + i, n - i);
+}
+
+inline const char* find_quote_or_escape_neon(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        uint8x16_t hit = vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\')));
+        uint64_t mask = neon_mask(hit);
+        if (mask != 0) {
+            return p + neon_first(mask);
+        }
+    }
+    return find_quote_or_escape_scalar(p, end);
+}
+
+inline const char* find_structural_neon(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        uint8x16_t hit = vorrq_u8(
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('['))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8(']')),
+                vorrq_u8(vceqq_u8(v, vdupq_n_u8('{')), vceqq_u8(v, vdupq_n_u8('}')))));
+        uint64_t mask = neon_mask(hit);
+        if (mask != 0) {
+            return p + neon_first(mask);
+        }
+    }
+    return find_structural_scalar(p, end);
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// runtime dispatch
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct Kernels {
+    size_t (*ascii_prefix)(const char*, size_t);
+    const char* (*find_quote_or_escape)(const char*, const char*);
+    const char* (*find_structural)(const char*, const char*);
+    const char* name;
+};
+
+inline Kernels select_kernels() {
+#if WRAPIDJSON_SIMD_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Kernels{ascii_prefix_avx2, find_quote_or_escape_avx2, find_structural_avx2, "avx2"};
+    }
+#endif
+#if WRAPIDJSON_SIMD_SSE2
+    return Kernels{ascii_prefix_sse2, find_quote_or_escape_sse2, find_structural_sse2, "sse2"};
+#elif WRAPIDJSON_SIMD_NEON
+    return Kernels{ascii_prefix_neon, find_quote_or_escape_neon, find_structural_neon, "neon"};
+#else
+    return Kernels{ascii_prefix_scalar, find_quote_or_escape_scalar, find_structural_scalar, "scalar"};
+#endif
+}
+
+inline const Kernels& kernels() {
+    static const Kernels selected = select_kernels();
+    return selected;
+}
+
+/// first '"' or '\\' in [p, end), end if none
+inline const char* find_quote_or_escape(const char* p, const char* end) {
+    return kernels().find_quote_or_escape(p, end);
+}
+
+/// first '"', '{', '}', '[' or ']' in [p, end), end if none
+inline const char* find_structural(const char* p, const char* end) {
+    return kernels().find_structural(p, end);
+}
+
+/// length of valid UTF-8 sequence at s ( non ASCII lead byte ), 0 if invalid
+inline size_t utf8_sequence(const unsigned char* s, size_t n) {
+    unsigned char c = s[0];
+    size_t len;
+    unsigned char lo = 0x80, hi = 0xBF;     // second byte range
+    if (c < 0xC2) {
+        return 0;                           // continuation or overlong
+    } else if (c < 0xE0) {
+        len = 2;
+    } else if (c < 0xF0) {
+        len = 3;
+        lo = (c == 0xE0) ? 0xA0 : 0x80;     // overlong
+        hi = (c == 0xED) ? 0x9F : 0xBF;     // surrogates
+    } else if (c < 0xF5) {
+        len = 4;
+        lo = (c == 0xF0) ? 0x90 : 0x80;     // overlong
+        hi = (c == 0xF4) ? 0x8F : 0xBF;     // > U+10FFFF
+    } else {
+        return 0;
+    }
+    if (n < len or s[1] < lo or s[1] > hi) {
+        return 0;
+    }
+    for (size_t i = 2; i < len; ++i) {
+        if ((s[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return len;
+}
+
+/// offset of first invalid UTF-8 byte, n if valid
+inline size_t find_invalid_utf8(const char* s, size_t n) {
+    const Kernels& k = kernels();
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(s);
+    size_t i = 0;
+    while (i < n) {
+        i += k.ascii_prefix(s + i, n - i);
+        // stay scalar through non ASCII runs
+        while (i < n and u[i] >= 0x80) {
+            size_t len = utf8_sequence(u + i, n - i);
+            if (len == 0) {
+                return i;
+            }
+            i += len;
+        }
+    }
+    return n;
+}
+
+inline bool validate_utf8(const char* s, size_t n) {
+    return find_invalid_utf8(s, n) == n;
+}
+
+} // namespace simd
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_SIMD_H_
@@ -0,0 +1,312 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_SNAPSHOT_H_
+#define WRAPIDJSON_SNAPSHOT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "document.h"
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Read only reference ( lookups never insert, nothing is written or allocated )
+///  - missing member reads as Null, like rapidjson's const operator[] without the assert
+///  - safe to use from many threads while nobody mutates the referenced value
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ConstRef {
+public:
+    ConstRef(const rapidjson::Value& value, const rapidjson::Document::AllocatorType& alloc)
+        : value_(&value), alloc_(&alloc) {}
+    ConstRef(const ValueRef& value)
+        : value_(value.value_), alloc_(value.alloc_) {}
+
+    /// get type info
+    bool is_bool() const { return value_->IsBool(); }
+    bool is_number() const { return value_->IsNumber(); }
+    bool is_integral() const {
+        return value_->IsInt() or value_->IsUint() or value_->IsInt64() or value_->IsUint64();
+    }
+    bool is_double() const { return value_->IsDouble(); }
+    bool is_string() const { return value_->IsString(); }
+    bool is_array() const { return value_->IsArray(); }
+    bool is_object() const { return value_->IsObject(); }
+    bool is_null() const { return value_->IsNull(); }
+
+    size_t size() const { return view().size(); }
+    bool empty() const { return view().empty(); }
+
+    /// member ( Null if missing or not object )
+    ConstRef operator[](const string_view& name) const {
+        auto found = find(name);
+        return found ? *found : null();
+    }
+    ConstRef operator[](const char* name) const { return operator[](string_view(name)); }
+    ConstRef operator[](const std::string& name) const { return operator[](string_view(name)); }
+    ConstRef operator[](const Key& key) const {
+        auto found = find(key);
+        return found ? *found : null();
+    }
+
+    /// element ( throws like ValueRef )
+    ConstRef operator[](size_t idx) const {
+        if ( not value_->IsArray() ) {
+            throw std::runtime_error(detail::format("ConstRef[%u] allow only ArrayType", idx));
+        } else if (idx >= value_->Size() ) {
+            throw std::runtime_error(detail::format("ConstRef[%u] out_of_range(%u)", idx, value_->Size()));
+        }
+        return ConstRef((*value_)[static_cast<rapidjson::SizeType>(idx)], *alloc_);
+    }
+
+    /// find member
+    optional<ConstRef> find(const string_view& name) const {
+        optional<ConstRef> res;
+        auto found = view().find(name);
+        if (found) {
+            res = ConstRef(*found);
+        }
+        return res;
+    }
+    optional<ConstRef> find(const Key& key) const {
+        optional<ConstRef> res;
+        auto found = view().find(key);
+        if (found) {
+            res = ConstRef(*found);
+        }
+        return res;
+    }
+
+    /// non throwing lookups ( see ValueRef::try_at / try_get )
+    Expected<ConstRef> try_at(size_t idx) const { return wrap(view().try_at(idx)); }
+    Expected<ConstRef> try_at(const string_view& name) const { return wrap(view().try_at(name)); }
+    Expected<ConstRef> try_at(const Key& key) const { return wrap(view().try_at(key)); }
+
+    template<typename T>
+    Expected<T> try_get() const { return view().try_get<T>(); }
+    template<typename T>
+    Expected<T> try_get(const string_view& name) const { return view().try_get<T>(name); }
+    template<typename T>
+    Expected<T> try_get(const Key& key) const { return view().try_get<T>(key); }
+
+    bool has(const string_view& name) const { return view().has(name); }
+    bool has(const Key& key) const { return view().has(key); }
+
+    /// same conversions as ValueRef::as<T> / get<T>
+    template<typename T>
+    auto as() const -> decltype(std::declval<ValueRef>().as<T>()) { return view().as<T>(); }
+
+    template<typename T>
+    auto get() const -> decltype(std::declval<ValueRef>().get<T>()) { return view().get<T>(); }
+
+    /// bulk numeric array into caller vector ( see ArrayRef::get_vector )
+    template<typename T>
+    bool get_vector(std::vector<T>& out) const {
+        return value_->IsArray() and ArrayRef(view()).get_vector(out);
+    }
+
+    std::string to_string(bool pretty = false) const { return view().to_string(pretty); }
+    bool write_to(std::string& buffer, bool pretty = false) const { return view().write_to(buffer, pretty); }
+    bool append_to(std::string& buffer, bool pretty = false) const { return view().append_to(buffer, pretty); }
+
+    const rapidjson::Value& get_rvalue() const { return *value_; }
+
+private:
+    /// ValueRef over the same value for its read paths, only const members are called,
+    /// so the value and allocator are never written
+    ValueRef view() const {
+        return ValueRef(const_cast<rapidjson::Value&>(*value_),
+                        const_cast<rapidjson::Document::AllocatorType&>(*alloc_));
+    }
+
+    static Expected<ConstRef> wrap(const Expected<ValueRef>& res) {
+        if (not res) {
+            return res.error();
+        }
+        return ConstRef(*res);
+    }
+
+    ConstRef null() const {
+        static const rapidjson::Value null_value;
+        return ConstRef(null_value, *alloc_);
+    }
+
+    const rapidjson::Value*                     value_;
+    const rapidjson::Document::AllocatorType*   alloc_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Immutable Document ( takes over a loaded Document, only read through ConstRef )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Snapshot {
+public:
+    Snapshot() = default;
+    explicit Snapshot(Document&& document) : document_(std::move(document)) {}
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    ConstRef root() const { return ConstRef(document_); }
+
+    ConstRef operator[](const string_view& name) const { return root()[name]; }
+    ConstRef operator[](const char* name) const { return root()[name]; }
+    ConstRef operator[](const std::string& name) const { return root()[name]; }
+    ConstRef operator[](const Key& key) const { return root()[key]; }
+
+    optional<ConstRef> find(const string_view& name) const { return root().find(name); }
+    optional<ConstRef> find(const Key& key) const { return root().find(key); }
+
+    bool has(const string_view& name) const { return root().has(name); }
+    bool has(const Key& key) const { return root().has(key); }
+
+    std::string to_string(bool pretty = false) const { return root().to_string(pretty); }
+
+    /// serialized in place, safe while other threads read ( see save_to_file_async )
+    bool save_to_file(const std::string& path, const SaveOptions& options = SaveOptions()) const {
+        return document_.write_to_file(path, options);
+    }
+
+    /// deep copy into new mutable Document
+    Document clone() const { return document_.clone(); }
+
+private:
+    Document document_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Shared current Snapshot, replaced RCU style
+///  - store  : publish a new Snapshot, readers pick it up on their next load / get
+///  - load   : current Snapshot ( short lock to copy shared_ptr )
+///  - Reader : per thread handle, get() is one atomic load while nothing was stored
+/// old Snapshot is released when its last holder ( reader or load result ) drops it
+///
+///   SharedSnapshot config(std::move(doc));
+///   // worker thread
+///   SharedSnapshot::Reader reader(config);
+///   auto port = reader.get()["server"]["port"].as<int>();
+///   // reload thread
+///   Document next;
+///   if (next.load_from_file(path)) config.store(std::move(next));
+/////////////////////////////////////////////////////////////////////////////////////////////
+class SharedSnapshot {
+public:
+    typedef std::shared_ptr<const Snapshot> pointer;
+
+    SharedSnapshot() : current_(std::make_shared<const Snapshot>()), version_(0) {}
+    explicit SharedSnapshot(Document&& document)
+        : current_(std::make_shared<const Snapshot>(std::move(document))), version_(0) {}
+
+    SharedSnapshot(const SharedSnapshot&) = delete;
+    SharedSnapshot& operator=(const SharedSnapshot&) = delete;
+
+    pointer load() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return current_;
+    }
+
+    /// publish document, returns previous Snapshot ( released here unless caller keeps it )
+    pointer store(Document&& document) {
+        return store(std::make_shared<const Snapshot>(std::move(document)));
+    }
+
+    pointer store(pointer snapshot) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            current_.swap(snapshot);
+            version_.fetch_add(1, std::memory_order_release);
+        }
+        return snapshot;
+    }
+
+    /// number of stores so far
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+    /////////////////////////////////////////////////////////////////////////////////////////
+    /// Cached view of SharedSnapshot for one thread ( not shared between threads )
+    ///  - keeps its Snapshot alive until next get() after a store, or release()
+    /////////////////////////////////////////////////////////////////////////////////////////
+    class Reader {
+    public:
+        explicit Reader(const SharedSnapshot& shared)
+            : shared_(&shared), version_(shared.version()), snapshot_(shared.load()) {}
+
+        const Snapshot& get() {
+            uint64_t version = shared_->version();
+            if (version != version_ or not snapshot_) {
+                snapshot_ = shared_->load();
+                version_ = version;
+            }
+            return *snapshot_;
+        }
+
+        const Snapshot& operator*() { return get(); }
+        const Snapshot* operator->() { return &get(); }
+
+        /// drop cached Snapshot ( e.g. before idling ), next get() loads again
+        void release() { snapshot_.reset(); }
+
+    private:
+        const SharedSnapshot*   shared_;
+        uint64_t                version_;
+        pointer                 snapshot_;
+    };
+
+private:
+    mutable std::mutex      mutex_;
+    pointer                 current_;
+    std::atomic<uint64_t>   version_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Save on a background thread, caller goes on while the file is serialized and written
+///  - the task holds the Snapshot until the write is done, nothing is copied
+///  - SharedSnapshot : current Snapshot, stores after the call do not change the file
+///  - Document&&     : taken over as a new Snapshot
+///
+///   auto saved = save_to_file_async(config, "/data/state.json", options);
+///   ...
+///   if (not saved.get()) { /* path keeps previous file when options.atomic */ }
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline std::future<bool> save_to_file_async(SharedSnapshot::pointer snapshot, const std::string& path,
+        const SaveOptions& options = SaveOptions()) {
+    return std::async(std::launch::async, [snapshot, path, options]() {
+        return snapshot and snapshot->save_to_file(path, options);
+    });
+}
+
+inline std::future<bool> save_to_file_async(const SharedSnapshot& shared, const std::string& path,
+        const SaveOptions& options = SaveOptions()) {
+    return save_to_file_async(shared.load(), path, options);
+}
+
+inline std::future<bool> save_to_file_async(Document&& document, const std::string& path,
+        const SaveOptions& options = SaveOptions()) {
+    return save_to_file_async(std::make_shared<const Snapshot>(std::move(document)), path, options);
+}
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_SNAPSHOT_H_
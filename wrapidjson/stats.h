@@ -0,0 +1,321 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef WRAPIDJSON_STATS_H_
+#define WRAPIDJSON_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <rapidjson/document.h>
+
+// compile with -DWRAPIDJSON_ENABLE_STATS=1 to count, otherwise every hook is empty inline
+#ifndef WRAPIDJSON_ENABLE_STATS
+#  define WRAPIDJSON_ENABLE_STATS 0
+#endif
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Process wide counters ( sum of thread local counters, zero without WRAPIDJSON_ENABLE_STATS )
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct Stats {
+    uint64_t parse_count = 0;
+    uint64_t parse_errors = 0;
+    uint64_t parse_bytes = 0;           // bytes in
+    uint64_t parse_ns = 0;              // wall time
+    uint64_t allocator_capacity = 0;    // MemoryPoolAllocator Capacity() after parse, summed
+    uint64_t allocator_size = 0;        // MemoryPoolAllocator Size() after parse, summed
+    uint64_t serialize_count = 0;
+    uint64_t serialize_bytes = 0;       // bytes out
+    uint64_t serialize_ns = 0;
+    uint64_t lookup_count = 0;          // ObjectRef find / has / get_value / operator[]
+    uint64_t lookup_miss = 0;
+    uint64_t deep_copy_count = 0;       // ValueRef::operator=, Document(const ValueRef&)
+};
+
+struct ParseEvent {
+    size_t      bytes;
+    uint64_t    nanoseconds;
+    size_t      allocator_capacity;
+    size_t      allocator_size;
+    bool        success;
+};
+
+struct SerializeEvent {
+    size_t      bytes;
+    uint64_t    nanoseconds;
+    bool        success;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Per event hook ( called on the parsing / serializing thread, keep it cheap )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class StatsHook {
+public:
+    virtual ~StatsHook() = default;
+    virtual void on_parse(const ParseEvent& event) { (void)event; }
+    virtual void on_serialize(const SerializeEvent& event) { (void)event; }
+    virtual void on_deep_copy() {}
+};
+
+namespace detail {
+namespace stats {
+
+enum Counter {
+    PARSE_COUNT, PARSE_ERRORS, PARSE_BYTES, PARSE_NS, ALLOCATOR_CAPACITY, ALLOCATOR_SIZE,
+    SERIALIZE_COUNT, SERIALIZE_BYTES, SERIALIZE_NS, LOOKUP_COUNT, LOOKUP_MISS, DEEP_COPY_COUNT,
+    COUNTER_SIZE
+};
+
+/// written by owner thread only ( no lock prefix ), read by get_stats()
+struct ThreadCounters {
+    std::atomic<uint64_t> values[COUNTER_SIZE];
+
+    ThreadCounters() {
+        for (auto& value : values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void add(Counter counter, uint64_t n) {
+        auto& value = values[counter];
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+struct Registry {
+    std::mutex                      mutex;
+    std::vector<ThreadCounters*>    live;
+    uint64_t                        retired[COUNTER_SIZE] = {};
+    std::atomic<StatsHook*>         hook{nullptr};
+};
+
+/// never destroyed, threads may exit after static destruction
+inline Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+struct ThreadSlot {
+    ThreadCounters counters;
+
+    ThreadSlot() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.live.push_back(&counters);
+    }
+
+    ~ThreadSlot() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (size_t i = 0; i < COUNTER_SIZE; ++i) {
+            r.retired[i] += counters.values[i].load(std::memory_order_relaxed);
+        }
+        r.live.erase(std::remove(r.live.begin(), r.live.end(), &counters), r.live.end());
+    }
+};
+
+inline ThreadCounters& counters() {
+    static thread_local ThreadSlot slot;
+    return slot.counters;
+}
+
+inline uint64_t elapsed_ns(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+#if WRAPIDJSON_ENABLE_STATS
+
+/// time one parse, done() records it and returns success
+class ParseScope {
+public:
+    ParseScope() : start_(std::chrono::steady_clock::now()) {}
+
+    bool done(rapidjson::Document& document, size_t bytes) {
+        return done(document, bytes, not document.HasParseError());
+    }
+
+    /// document was built by other means than rapidjson parse ( e.g. MessagePack )
+    bool done(rapidjson::Document& document, size_t bytes, bool success) {
+        ParseEvent event{bytes, elapsed_ns(start_), document.GetAllocator().Capacity(),
+            document.GetAllocator().Size(), success};
+        ThreadCounters& c = counters();
+        c.add(PARSE_COUNT, 1);
+        c.add(PARSE_ERRORS, event.success ? 0 : 1);
+        c.add(PARSE_BYTES, event.bytes);
+        c.add(PARSE_NS, event.nanoseconds);
+        c.add(ALLOCATOR_CAPACITY, event.allocator_capacity);
+        c.add(ALLOCATOR_SIZE, event.allocator_size);
+        StatsHook* hook = registry().hook.load(std::memory_order_acquire);
+        if (hook != nullptr) {
+            hook->on_parse(event);
+        }
+        return event.success;
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+class SerializeScope {
+public:
+    SerializeScope() : start_(std::chrono::steady_clock::now()) {}
+
+    bool done(size_t bytes, bool success) {
+        SerializeEvent event{bytes, elapsed_ns(start_), success};
+        ThreadCounters& c = counters();
+        c.add(SERIALIZE_COUNT, 1);
+        c.add(SERIALIZE_BYTES, event.bytes);
+        c.add(SERIALIZE_NS, event.nanoseconds);
+        StatsHook* hook = registry().hook.load(std::memory_order_acquire);
+        if (hook != nullptr) {
+            hook->on_serialize(event);
+        }
+        return success;
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+inline void lookup(bool found) {
+    ThreadCounters& c = counters();
+    c.add(LOOKUP_COUNT, 1);
+    c.add(LOOKUP_MISS, found ? 0 : 1);
+}
+
+inline void deep_copy() {
+    counters().add(DEEP_COPY_COUNT, 1);
+    StatsHook* hook = registry().hook.load(std::memory_order_acquire);
+    if (hook != nullptr) {
+        hook->on_deep_copy();
+    }
+}
+
+#else
+
+class ParseScope {
+public:
+    bool done(rapidjson::Document& document, size_t) { return not document.HasParseError(); }
+    bool done(rapidjson::Document&, size_t, bool success) { return success; }
+};
+
+class SerializeScope {
+public:
+    bool done(size_t, bool success) { return success; }
+};
+
+inline void lookup(bool) {}
+inline void deep_copy() {}
+
+#endif
+
+} // namespace stats
+} // namespace detail
+
+/// sum of every thread ( exited threads included )
+inline Stats get_stats() {
+    using namespace detail::stats;
+    uint64_t values[COUNTER_SIZE];
+    Registry& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (size_t i = 0; i < COUNTER_SIZE; ++i) {
+            values[i] = r.retired[i];
+        }
+        for (ThreadCounters* c : r.live) {
+            for (size_t i = 0; i < COUNTER_SIZE; ++i) {
+                values[i] += c->values[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    Stats stats;
+    stats.parse_count = values[PARSE_COUNT];
+    stats.parse_errors = values[PARSE_ERRORS];
+    stats.parse_bytes = values[PARSE_BYTES];
+    stats.parse_ns = values[PARSE_NS];
+    stats.allocator_capacity = values[ALLOCATOR_CAPACITY];
+    stats.allocator_size = values[ALLOCATOR_SIZE];
+    stats.serialize_count = values[SERIALIZE_COUNT];
+    stats.serialize_bytes = values[SERIALIZE_BYTES];
+    stats.serialize_ns = values[SERIALIZE_NS];
+    stats.lookup_count = values[LOOKUP_COUNT];
+    stats.lookup_miss = values[LOOKUP_MISS];
+    stats.deep_copy_count = values[DEEP_COPY_COUNT];
+    return stats;
+}
+
+/// zero counters of every thread ( counts racing with reset may be lost )
+inline void reset_stats() {
+    using namespace detail::stats;
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (size_t i = 0; i < COUNTER_SIZE; ++i) {
+        r.retired[i] = 0;
+    }
+    for (ThreadCounters* c : r.live) {
+        for (auto& value : c->values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+/// hook is not owned, nullptr to remove
+inline void set_stats_hook(StatsHook* hook) {
+    detail::stats::registry().hook.store(hook, std::memory_order_release);
+}
+
+/// Prometheus text exposition format
+inline std::string format_prometheus(const Stats& stats, const std::string& prefix = "wrapidjson") {
+    struct Metric { const char* name; const char* type; uint64_t value; };
+    const Metric metrics[] = {
+        {"parse_total", "counter", stats.parse_count},
+        {"parse_errors_total", "counter", stats.parse_errors},
+        {"parse_bytes_total", "counter", stats.parse_bytes},
+        {"parse_nanoseconds_total", "counter", stats.parse_ns},
+        {"allocator_capacity_bytes_total", "counter", stats.allocator_capacity},
+        {"allocator_size_bytes_total", "counter", stats.allocator_size},
+        {"serialize_total", "counter", stats.serialize_count},
+        {"serialize_bytes_total", "counter", stats.serialize_bytes},
+        {"serialize_nanoseconds_total", "counter", stats.serialize_ns},
+        {"lookup_total", "counter", stats.lookup_count},
+        {"lookup_miss_total", "counter", stats.lookup_miss},
+        {"deep_copy_total", "counter", stats.deep_copy_count},
+    };
+    std::string out;
+    for (const auto& metric : metrics) {
+        std::string name = prefix + "_" + metric.name;
+        out += "# TYPE " + name + " " + metric.type + "\n";
+        out += name + " " + std::to_string(metric.value) + "\n";
+    }
+    return out;
+}
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_STATS_H_
@@ -0,0 +1,141 @@
+#ifndef WRAPIDJSON_STREAM_H_
+#define WRAPIDJSON_STREAM_H_
+
+#include <istream>
+#include <ostream>
+#include <memory>
+#include <stdexcept>
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// std::istream wrapper
+///  - read std::streambuf by block, only bytes already available ( never blocks for
+///    more bytes than parser needs )
+///  - unread bytes are given back to streambuf on destruction, if it is seekable
+/////////////////////////////////////////////////////////////////////////////////////////////
+class IStream {
+public:
+    using Ch = char;
+    static const size_t DEFAULT_BUFFER_SIZE = 65536;
+
+    IStream(std::istream& is, size_t buffer_size = DEFAULT_BUFFER_SIZE)
+        : is_(is)
+        , buffer_size_(buffer_size > 0 ? buffer_size : 1)
+        , buffer_(new Ch[buffer_size_])
+        , current_(buffer_.get())
+        , end_(buffer_.get())
+        , count_(0)
+        , eof_(false)
+    {}
+    IStream(const IStream&) = delete;
+    IStream& operator=(const IStream&) = delete;
+
+    ~IStream() {
+        std::streambuf* sb = is_.rdbuf();
+        std::streamoff unread = static_cast<std::streamoff>(end_ - current_);
+        if (sb != nullptr and unread > 0) {
+            sb->pubseekoff(-unread, std::ios_base::cur, std::ios_base::in);
+        }
+    }
+
+    /// block is refilled only when parser asks for the byte after it
+    Ch Peek() { return available() ? *current_ : '\0'; }
+    Ch Take() { return available() ? *current_++ : '\0'; }
+    size_t Tell() const { return count_ + static_cast<size_t>(current_ - buffer_.get()); }
+
+    Ch* PutBegin() { throw std::runtime_error("IStream::PutBegin not implement"); }
+    void Put(Ch) { throw std::runtime_error("IStream::Put not implement"); }
+    void Flush() { throw std::runtime_error("IStream::Flush not implement"); }
+    size_t PutEnd(Ch*) { throw std::runtime_error("IStream::PutEnd not implement"); }
+
+private:
+    bool available() {
+        if (current_ == end_ and not eof_) {
+            count_ += static_cast<size_t>(end_ - buffer_.get());
+            current_ = end_ = buffer_.get();
+            end_ += Fill();
+            if (current_ == end_) {
+                eof_ = true;
+                is_.setstate(std::ios_base::eofbit);
+            }
+        }
+        return current_ != end_;
+    }
+
+    size_t Fill() {
+        std::streambuf* sb = is_.rdbuf();
+        if (sb == nullptr) {
+            return 0;
+        }
+        std::streamsize avail = sb->in_avail();
+        std::streamsize want = 1;    // nothing buffered, wait for one byte
+        if (avail > 0) {
+            want = avail < static_cast<std::streamsize>(buffer_size_) ?
+                avail : static_cast<std::streamsize>(buffer_size_);
+        }
+        std::streamsize n = sb->sgetn(buffer_.get(), want);
+        return n > 0 ? static_cast<size_t>(n) : 0;
+    }
+
+    std::istream&           is_;
+    size_t                  buffer_size_;
+    std::unique_ptr<Ch[]>   buffer_;
+    Ch*                     current_;
+    Ch*                     end_;
+    size_t                  count_;     // bytes before current block
+    bool                    eof_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// std::ostream wrapper
+///  - collect output in block, write to std::ostream when full or Flush
+/////////////////////////////////////////////////////////////////////////////////////////////
+class OStream {
+public:
+    using Ch = char;
+    static const size_t DEFAULT_BUFFER_SIZE = 65536;
+
+    OStream(std::ostream& os, size_t buffer_size = DEFAULT_BUFFER_SIZE)
+        : os_(os)
+        , buffer_size_(buffer_size > 0 ? buffer_size : 1)
+        , buffer_(new Ch[buffer_size_])
+        , current_(buffer_.get())
+        , end_(buffer_.get() + buffer_size_)
+    {}
+    OStream(const OStream&) = delete;
+    OStream& operator=(const OStream&) = delete;
+
+    ~OStream() { Write(); }
+
+    Ch Peek() const { throw std::runtime_error("OStream::Peek not implement"); }
+    Ch Take() { throw std::runtime_error("OStream::Take not implement"); }
+    size_t Tell() const { throw std::runtime_error("OStream::Tell not implement"); }
+    Ch* PutBegin() { throw std::runtime_error("OStream::PutBegin not implement"); }
+    void Put(Ch c) {
+        if (current_ == end_) {
+            Write();
+        }
+        *current_++ = c;
+    }
+    void Flush() { Write(); os_.flush(); }
+    size_t PutEnd(Ch*) { throw std::runtime_error("OStream::PutEnd not implement"); }
+
+private:
+    void Write() {
+        if (current_ != buffer_.get()) {
+            os_.write(buffer_.get(), current_ - buffer_.get());
+            current_ = buffer_.get();
+        }
+    }
+
+    std::ostream&           os_;
+    size_t                  buffer_size_;
+    std::unique_ptr<Ch[]>   buffer_;
+    Ch*                     current_;
+    Ch*                     end_;
+};
+
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_STREAM_H_
@@ -6,6 +6,8 @@
 #include <unordered_map>
 #include <type_traits>
 
+#include "string_view.hpp"
+
 namespace wrapidjson {
 namespace detail {
 
@@ -30,6 +32,12 @@ struct is_string : std::false_type {};
 template<typename ...Args>
 struct is_string<std::basic_string<Args...> > : std::true_type {};
 
+////////////////////////////////////////////////////////////////////////////////
+// is_string_view
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+struct is_string_view : std::is_same<T, nonstd::string_view> {};
+
 ////////////////////////////////////////////////////////////////////////////////
 // is_const_char
 ////////////////////////////////////////////////////////////////////////////////
@@ -67,6 +75,24 @@ struct is_iterable<T, void_t<decltype(std::declval<T>().begin()),
                              decltype(std::declval<T>().end())>>
     : std::true_type {};
 
+////////////////////////////////////////////////////////////////////////////////
+// is_string_map ( map with std::string key )
+////////////////////////////////////////////////////////////////////////////////
+template<typename T, typename = void>
+struct is_string_map : std::false_type {};
+
+template<typename T>
+struct is_string_map<T, enable_if_t<is_map<T>::value>>
+    : std::is_same<typename T::key_type, std::string> {};
+
+////////////////////////////////////////////////////////////////////////////////
+// is_array_container ( iterable written as JSON array )
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+struct is_array_container : std::integral_constant<bool,
+    is_iterable<T>::value && !is_map<T>::value &&
+    !is_string<T>::value && !is_string_view<T>::value> {};
+
 ////////////////////////////////////////////////////////////////////////////////
 // enable_if_*_t
 ////////////////////////////////////////////////////////////////////////////////
@@ -79,6 +105,8 @@ using enable_if_cptr_t  = enable_if_t<is_const_char<T>::value, T>;
 template<typename T>
 using enable_if_str_t   = enable_if_t<is_string<T>::value, T>;
 template<typename T>
+using enable_if_sv_t    = enable_if_t<is_string_view<T>::value, T>;
+template<typename T>
 using enable_if_num_t   = enable_if_t<std::is_arithmetic<T>::value &&
                             !std::is_same<T, char>::value, T>;
 template<typename T>
@@ -115,42 +143,6 @@ using enable_if_sequence_t = enable_if_t<
     is_iterable<Container<T, Args...>>::value &&
     !is_map<Container<T, Args...>>::value, Container<T, Args...>>;
 
-////////////////////////////////////////////////////////////////////////////////
-// enable_if_l_sequence  ( long != int64_t )
-////////////////////////////////////////////////////////////////////////////////
-template<template <typename...> class Container, typename...Args>
-using enable_if_l_sequence_t = enable_if_t<
-    !std::is_same<int64_t, long>::value &&
-    is_iterable<Container<long, Args...>>::value &&
-    !is_map<Container<long, Args...>>::value, Container<long, Args...>>;
-
-////////////////////////////////////////////////////////////////////////////////
-// enable_if_ul_sequence  ( unsigned long != uint64_t )
-////////////////////////////////////////////////////////////////////////////////
-template<template <typename...> class Container, typename...Args>
-using enable_if_ul_sequence_t = enable_if_t<
-    !std::is_same<uint64_t, unsigned long>::value &&
-    is_iterable<Container<unsigned long, Args...>>::value &&
-    !is_map<Container<unsigned long, Args...>>::value, Container<unsigned long, Args...>>;
-
-////////////////////////////////////////////////////////////////////////////////
-// enable_if_ll_sequence ( long long != int64_t )
-////////////////////////////////////////////////////////////////////////////////
-template<template <typename...> class Container, typename...Args>
-using enable_if_ll_sequence_t = enable_if_t<
-    !std::is_same<int64_t, long long>::value &&
-    is_iterable<Container<long long, Args...>>::value &&
-    !is_map<Container<long long, Args...>>::value, Container<long long, Args...>>;
-
-////////////////////////////////////////////////////////////////////////////////
-// enable_if_ll_sequence ( unsigned long long != uint64_t )
-////////////////////////////////////////////////////////////////////////////////
-template<template <typename...> class Container, typename...Args>
-using enable_if_ull_sequence_t = enable_if_t<
-    !std::is_same<uint64_t, unsigned long long>::value &&
-    is_iterable<Container<unsigned long long, Args...>>::value &&
-    !is_map<Container<unsigned long long, Args...>>::value, Container<unsigned long long, Args...>>;
-
 ////////////////////////////////////////////////////////////////////////////////
 // enable_if_str_map
 ////////////////////////////////////////////////////////////////////////////////
@@ -159,42 +151,6 @@ using enable_if_strmap_t = enable_if_t<
     is_map<Container<std::string, T, Args...>>::value
     , Container<std::string, T, Args...>>;
 
-////////////////////////////////////////////////////////////////////////////////
-// enable_if_str_l_map ( long != int64_t )
-////////////////////////////////////////////////////////////////////////////////
-template<template <typename...> class Container, typename...Args>
-using enable_if_str_l_map_t = enable_if_t<
-    !std::is_same<int64_t, long>::value &&
-    is_map<Container<std::string, long, Args...>>::value
-    , Container<std::string, long, Args...>>;
-
-////////////////////////////////////////////////////////////////////////////////
-// enable_if_str_ul_map ( unsigned long != uint64_t )
-////////////////////////////////////////////////////////////////////////////////
-template<template <typename...> class Container, typename...Args>
-using enable_if_str_ul_map_t = enable_if_t<
-    !std::is_same<uint64_t, unsigned long>::value &&
-    is_map<Container<std::string, unsigned long, Args...>>::value
-    , Container<std::string, unsigned long, Args...>>;
-
-////////////////////////////////////////////////////////////////////////////////
-// enable_if_str_ll_map ( long long != int64_t )
-////////////////////////////////////////////////////////////////////////////////
-template<template <typename...> class Container, typename...Args>
-using enable_if_str_ll_map_t = enable_if_t<
-    !std::is_same<int64_t, long long>::value &&
-    is_map<Container<std::string, long long, Args...>>::value
-    , Container<std::string, long long, Args...>>;
-
-////////////////////////////////////////////////////////////////////////////////
-// enable_if_str_ull_map ( long long != int64_t )
-////////////////////////////////////////////////////////////////////////////////
-template<template <typename...> class Container, typename...Args>
-using enable_if_str_ull_map_t = enable_if_t<
-    !std::is_same<uint64_t, unsigned long long>::value &&
-    is_map<Container<std::string, unsigned long long, Args...>>::value
-    , Container<std::string, unsigned long long, Args...>>;
-
 } // namespace detail
 } // namespace wrapidjson
 
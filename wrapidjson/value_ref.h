@@ -23,13 +23,24 @@
 #define WRAPIDJSON_VALUE_REF_H
 
 #include <limits>
+#include <iosfwd>
+#include <memory>
+#include <tuple>
+
+#include "simd.h"
 
 #include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
 
 #include "string_view.hpp"
 #include "optional.hpp"
 
+#include "error.h"
+#include "file_writer.h"
 #include "type_traits.h"
+#include "key.h"
+#include "column.h"
+#include "member_index.h"
 
 namespace wrapidjson {
 
@@ -89,6 +100,9 @@ class ArrayRef;
 class ObjectRef;
 class Document;
 struct MemberRef;
+class Path;
+class PathSet;
+class ConstRef;
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// Iterator for ValueRef, ArrayRef, ObjectRef
@@ -102,6 +116,9 @@ using MemberIterator = Iterator<rapidjson::Value::MemberIterator, MemberRef, rap
 class ValueRef {
     friend class ArrayRef;
     friend class ObjectRef;
+    friend class Path;
+    friend class PathSet;
+    friend class ConstRef;
 
 public:
     /// constructors:
@@ -118,9 +135,22 @@ public:
     ValueRef& operator=(const ValueRef&);
     ValueRef& operator=(const Document&);
 
+    /// true if both values allocate from the same allocator ( same Document or shared Arena )
+    bool shares_allocator(const ValueRef& other) const { return alloc_ == other.alloc_; }
+
+    /// take other's value, other becomes Null ( other must not contain this value )
+    ///  - shared allocator : O(1), nothing is copied
+    ///  - otherwise        : deep copy
+    ValueRef& move_from(ValueRef other);
+
+    /// exchange values ( neither may contain the other )
+    ///  - shared allocator : O(1), nothing is copied
+    ///  - otherwise        : both values are deep copied
+    void swap(ValueRef other);
+
     template<typename T>
     ValueRef& operator=(T value) {
-        value_ = value;
+        *value_ = value;
         return *this;
     }
 
@@ -128,12 +158,12 @@ public:
     // IF long != int64_t
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     ValueRef& operator=(long value) {
-        value_ = static_cast<int64_t>(value);
+        *value_ = static_cast<int64_t>(value);
         return *this;
     }
 
     ValueRef& operator=(unsigned long value) {
-        value_ = static_cast<uint64_t>(value);
+        *value_ = static_cast<uint64_t>(value);
         return *this;
     }
 
@@ -141,19 +171,19 @@ public:
     // IF long long != int64_t
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     ValueRef& operator=(long long value) {
-        value_ = static_cast<int64_t>(value);
+        *value_ = static_cast<int64_t>(value);
         return *this;
     }
 
     ValueRef& operator=(unsigned long long value) {
-        value_ = static_cast<uint64_t>(value);
+        *value_ = static_cast<uint64_t>(value);
         return *this;
     }
 
     /// catches string literals (without copying):
     template<int N>
     ValueRef& operator=(const char(&s)[N]) {
-        value_.SetString(s, N-1); // we don't want to store the \0 character
+        value_->SetString(s, N-1); // we don't want to store the \0 character
         return *this;
     }
 
@@ -177,33 +207,21 @@ public:
         return *this;
     }
 
-    /// set Container ( Container<Number> )
+    /// set Container ( Container<T> -> Array ), T may be a nested container
     template<typename T, template <typename...> class Container, typename...Args,
         detail::enable_if_sequence_t<T, Container, Args...>* = nullptr
     >
     void set_container(const Container<T, Args...>& array, bool str_copy = true);
 
-    /// set Container ( Continaer<String> )
-    template<template <typename...> class Container, typename...Args,
-        detail::enable_if_sequence_t<std::string, Container, Args...>* = nullptr
-    >
-    void set_container(const Container<std::string, Args...>& array, bool str_copy = true);
-
-    /// assign from map<string, Number>
+    /// assign from map<string, T> ( -> Object ), T may be a nested container
     template<typename T, template <typename...> class Container, typename...Args,
         detail::enable_if_strmap_t<T, Container, Args...>* = nullptr
     >
     void set_container(const Container<std::string, T, Args...>& map, bool str_copy = true);
 
-    /// assign from map<string, string>
-    template<template <typename...> class Container, typename ...Args,
-        detail::enable_if_strmap_t<std::string, Container, Args...>* = nullptr
-    >
-    void set_container(const Container<std::string, std::string>& map, bool str_copy = true);
-
     /// set to Null
     ValueRef& set_null() {
-        value_.SetNull();
+        value_->SetNull();
         return *this;
     }
 
@@ -225,26 +243,44 @@ public:
     /// set to Object
     ValueRef operator[](const std::string& name) const;
 
+    /// set to Object ( precomputed Key )
+    ValueRef operator[](const Key& key) const;
+
     /// check member
-    bool has(const std::string& name) const;
+    bool has(const string_view& name) const;
+    bool has(const Key& key) const;
 
     /// find member
-    optional<ValueRef> find(const std::string& name) const;
+    optional<ValueRef> find(const string_view& name) const;
+    optional<ValueRef> find(const Key& key) const;
+
+    /// non throwing lookups ( nothing is inserted, formatted or allocated, see error.h )
+    Expected<ValueRef> try_at(size_t idx) const;
+    Expected<ValueRef> try_at(const string_view& name) const;
+    Expected<ValueRef> try_at(const Key& key) const;
+
+    /// get<T>() with the reason when it is empty
+    template<typename T>
+    Expected<T> try_get() const;
+    template<typename T>
+    Expected<T> try_get(const string_view& name) const;
+    template<typename T>
+    Expected<T> try_get(const Key& key) const;
 
     /// get type info
-    bool is_bool() const { return value_.IsBool(); }
-    bool is_number() const { return value_.IsNumber(); }
+    bool is_bool() const { return value_->IsBool(); }
+    bool is_number() const { return value_->IsNumber(); }
     bool is_integral() const {
-        return value_.IsInt() or value_.IsUint() or value_.IsInt64() or value_.IsUint64();
+        return value_->IsInt() or value_->IsUint() or value_->IsInt64() or value_->IsUint64();
     }
-    bool is_double() const { return value_.IsDouble(); }
-    bool is_string() const { return value_.IsString(); }
-    bool is_array() const { return value_.IsArray(); }
-    bool is_object() const { return value_.IsObject(); }
-    bool is_null() const { return value_.IsNull(); }
+    bool is_double() const { return value_->IsDouble(); }
+    bool is_string() const { return value_->IsString(); }
+    bool is_array() const { return value_->IsArray(); }
+    bool is_object() const { return value_->IsObject(); }
+    bool is_null() const { return value_->IsNull(); }
 
     /// test if two Values point to the same rapidjson::Value
-    bool operator==(const ValueRef& other) { return (&value_ == &other.value_); }
+    bool operator==(const ValueRef& other) { return (value_ == other.value_); }
     bool operator!=(const ValueRef& other) { return !(operator==(other)); }
 
     /// type = as<type>
@@ -260,6 +296,10 @@ public:
     template<typename T, detail::enable_if_str_t<T>* = nullptr>
     std::string as() const;
 
+    /// view into DOM string ( no copy, empty if not string )
+    template<typename T, detail::enable_if_sv_t<T>* = nullptr>
+    string_view as() const;
+
 
     /// optional<type> = get<type>
     template<typename T, detail::enable_if_bool_t<T>* = nullptr>
@@ -297,6 +337,10 @@ public:
     template<typename T, detail::enable_if_str_t<T>* = nullptr>
     optional<std::string> get() const;
 
+    // string_view ( view into DOM string, no copy )
+    template<typename T, detail::enable_if_sv_t<T>* = nullptr>
+    optional<string_view> get() const;
+
     ValueRef get_ref() const;
     ArrayRef get_array() const;
     ObjectRef get_object() const;
@@ -305,68 +349,26 @@ public:
 
     ValueRef* operator->() { return this; } // for iterator
 
-    std::string to_string();
+    /// serialize referenced value ( no copy into temporary Document )
+    ///  - std::string            : contents are replaced, written in place ( capacity is reused )
+    ///  - rapidjson::StringBuffer : appended, Clear() and reuse it across calls
+    ///  - append_to               : appended to std::string
+    std::string to_string(bool pretty = false) const;
+    bool write_to(std::string& buffer, bool pretty = false) const;
+    bool append_to(std::string& buffer, bool pretty = false) const;
+    bool write_to(rapidjson::StringBuffer& buffer, bool pretty = false) const;
+    bool write_to(std::ostream& os, bool pretty = false) const;
+    bool write_to_file(const std::string& path, bool pretty = false) const;
+    bool write_to_file(const std::string& path, const SaveOptions& options) const;
 
     bool empty() const;
 
     size_t size() const;
 
-    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-    // IF long != int64_t
-    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-    /// set Container ( Container<long> )
-    template<template <typename...> class Container, typename...Args,
-        detail::enable_if_l_sequence_t<Container, Args...>* = nullptr
-    >
-    void set_container(const Container<long, Args...>& array, bool str_copy = true);
-
-    /// set Container ( Container<unsigned long> )
-    template<template <typename...> class Container, typename...Args,
-        detail::enable_if_ul_sequence_t<Container, Args...>* = nullptr
-    >
-    void set_container(const Container<unsigned long, Args...>& array, bool str_copy = true);
-
-    /// assing from map<string, long> ( long != int64_t )
-    template<template <typename...> class Container, typename...Args,
-        detail::enable_if_str_l_map_t<Container, Args...>* = nullptr
-    >
-    void set_container(const Container<std::string, long, Args...>& map, bool str_copy = true);
-
-    /// assing from map<string, unsinged long> ( unsigned long != uint64_t )
-    template<template <typename...> class Container, typename...Args,
-        detail::enable_if_str_ul_map_t<Container, Args...>* = nullptr
-    >
-    void set_container(const Container<std::string, unsigned long, Args...>& map, bool str_copy = true);
-
-    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-    // IF long long != int64_t
-    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-    /// set Container ( Container<long long> )
-    template<template <typename...> class Container, typename...Args,
-        detail::enable_if_ll_sequence_t<Container, Args...>* = nullptr
-    >
-    void set_container(const Container<long long, Args...>& array, bool str_copy = true);
-
-    /// set Container ( Container<unsigned long long> )
-    template<template <typename...> class Container, typename...Args,
-        detail::enable_if_ull_sequence_t<Container, Args...>* = nullptr
-    >
-    void set_container(const Container<unsigned long long, Args...>& array, bool str_copy = true);
-    /// assing from map<string, long long> ( long long != int64_t )
-    template<template <typename...> class Container, typename...Args,
-        detail::enable_if_str_ll_map_t<Container, Args...>* = nullptr
-    >
-    void set_container(const Container<std::string, long long, Args...>& map, bool str_copy = true);
-
-    /// assing from map<string, unsinged long long> ( unsigned long long != uint64_t )
-    template<template <typename...> class Container, typename...Args,
-        detail::enable_if_str_ull_map_t<Container, Args...>* = nullptr
-    >
-    void set_container(const Container<std::string, unsigned long long, Args...>& map, bool str_copy = true);
-
 protected:
-    rapidjson::Value&                   value_;
-    rapidjson::Document::AllocatorType& alloc_;
+    // pointers, not references, so Document can rebind its root on move
+    rapidjson::Value*                   value_;
+    rapidjson::Document::AllocatorType* alloc_;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -410,22 +412,79 @@ public:
     ValueRef front() const;
     ValueRef back() const;
 
+    /// all elements as T, nullopt if any element is not T
+    /// ( arithmetic T : one type check pass then one fill pass over raw values )
     template <typename T>
     optional<std::vector<T>> get_vector();
 
+    /// into caller vector ( capacity is reused ), false and out unchanged if any element is not T
+    template <typename T>
+    bool get_vector(std::vector<T>& out) const;
+
+    /// into caller buffer of n >= size() elements, arithmetic T only
     template <typename T>
-    std::vector<T> as_vector(std::function<bool(const T&)> func = [](const T&){return true;});
+    bool copy_to(T* out, size_t n) const;
+
+    template <typename T>
+    std::vector<T> as_vector();
+
+    template <typename T>
+    std::vector<T> as_vector(std::function<bool(const T&)> func);
 
     template<typename T>
     void push_back(T&& value);
+
+    /// reserve then fill, arithmetic T only
+    template<typename T>
+    void append(const T* data, size_t n);
+
+    /// array of objects to struct of arrays in one pass over rows
+    ///   std::vector<int64_t> ts; std::vector<double> v;
+    ///   array.get_columns(column("ts", ts), column("v", v));
+    /// false if a row is not object, a required member is missing or a value is not T
+    /// ( every column is cleared on failure )
+    template <typename... Ts>
+    bool get_columns(const Column<Ts>&... columns) const;
     ValueRef push_back();
     void pop_back();
     ValueIterator erase(const ValueIterator& pos);
     ValueIterator erase(const ValueIterator& first, const ValueIterator& last);
 
+    /// serialize referenced value ( see ValueRef::write_to )
+    std::string to_string(bool pretty = false) const;
+    bool write_to(std::string& buffer, bool pretty = false) const;
+    bool append_to(std::string& buffer, bool pretty = false) const;
+    bool write_to(rapidjson::StringBuffer& buffer, bool pretty = false) const;
+    bool write_to(std::ostream& os, bool pretty = false) const;
+    bool write_to_file(const std::string& path, bool pretty = false) const;
+    bool write_to_file(const std::string& path, const SaveOptions& options) const;
+
     ValueRef get_value_ref() const;
 
 protected:
+    template <typename T>
+    bool get_elements(std::vector<T>& out, std::true_type) const;
+    template <typename T>
+    bool get_elements(std::vector<T>& out, std::false_type) const;
+
+    template <typename T>
+    bool get_element(rapidjson::Value& value, T& out, std::true_type) const;
+    template <typename T>
+    bool get_element(rapidjson::Value& value, T& out, std::false_type) const;
+
+    template <size_t I, typename Tuple>
+    detail::enable_if_t<(I < std::tuple_size<Tuple>::value), bool>
+    get_row(rapidjson::Value& row, const Tuple& columns, size_t* hints) const;
+    template <size_t I, typename Tuple>
+    detail::enable_if_t<(I == std::tuple_size<Tuple>::value), bool>
+    get_row(rapidjson::Value& row, const Tuple& columns, size_t* hints) const;
+    template <size_t I, typename Tuple>
+    detail::enable_if_t<(I < std::tuple_size<Tuple>::value)>
+    clear_columns(const Tuple& columns, size_t reserve) const;
+    template <size_t I, typename Tuple>
+    detail::enable_if_t<(I == std::tuple_size<Tuple>::value)>
+    clear_columns(const Tuple& columns, size_t reserve) const;
+
     ValueRef valueRef_;
 };
 
@@ -457,40 +516,64 @@ public:
 
     /// get_value<String>()
     template<typename T, detail::enable_if_str_t<T>* = nullptr>
-    optional<std::string> get_value(const std::string& name) const;
+    optional<std::string> get_value(const string_view& name) const;
 
     /// get_value<const char>()
     template<typename T, detail::enable_if_cptr_t<T>* = nullptr>
-    optional<const char*> get_value(const std::string& name) const;
+    optional<const char*> get_value(const string_view& name) const;
+
+    /// get_value<string_view>() ( view into DOM string, no copy )
+    template<typename T, detail::enable_if_sv_t<T>* = nullptr>
+    optional<string_view> get_value(const string_view& name) const;
 
     /// get_value<Number>()
     template<typename T, detail::enable_if_num_t<T>* = nullptr>
-    optional<T> get_value(const std::string& name) const;
+    optional<T> get_value(const string_view& name) const;
 
     /// get_value<T>(default_value)
     template<typename T>
-    T get_value(const std::string& name, const T& defval) const;
+    T get_value(const string_view& name, const T& defval) const;
+
+    /// get_value by precomputed Key
+    template<typename T, detail::enable_if_str_t<T>* = nullptr>
+    optional<std::string> get_value(const Key& key) const;
+
+    template<typename T, detail::enable_if_cptr_t<T>* = nullptr>
+    optional<const char*> get_value(const Key& key) const;
+
+    template<typename T, detail::enable_if_sv_t<T>* = nullptr>
+    optional<string_view> get_value(const Key& key) const;
+
+    template<typename T, detail::enable_if_num_t<T>* = nullptr>
+    optional<T> get_value(const Key& key) const;
+
+    template<typename T>
+    T get_value(const Key& key, const T& defval) const;
 
     ValueRef operator[](const std::string& name) const;
     ValueRef operator[](const char* name) const;
     ValueRef operator[](const string_view& name) const;
+    ValueRef operator[](const Key& key) const;
 
-    optional<ValueRef> find(const std::string& name) const;
+    optional<ValueRef> find(const string_view& name) const;
+    optional<ValueRef> find(const Key& key) const;
 
     template<template <typename...> class Container, typename...Args,
         detail::enable_if_sequence_t<std::string, Container, Args...>* = nullptr
     >
-    MemberIterator find_any(Container<std::string> names) const;
+    MemberIterator find_any(const Container<std::string>& names) const;
 
     template<template <typename...> class Container, typename...Args,
         detail::enable_if_sequence_t<std::string, Container, Args...>* = nullptr
     >
-    bool find_all(Container<std::string> names) const;
+    bool find_all(const Container<std::string>& names) const;
 
-    int count(const std::string& name) const;
+    int count(const string_view& name) const;
+    int count(const Key& key) const;
     size_t size() const;
     bool empty() const;
-    bool has(const std::string& name) const;
+    bool has(const string_view& name) const;
+    bool has(const Key& key) const;
     void clear();
 
     MemberIterator begin() const;
@@ -509,13 +592,40 @@ public:
     ValueRef insert(const std::string& name);
     ValueRef insert(const string_view& name);
 
-    MemberIterator erase(const std::string& name);
+    MemberIterator erase(const string_view& name);
     MemberIterator erase(const MemberIterator& pos);
     MemberIterator erase(const MemberIterator& first, const MemberIterator& last);
 
+    /// serialize referenced value ( see ValueRef::write_to )
+    std::string to_string(bool pretty = false) const;
+    bool write_to(std::string& buffer, bool pretty = false) const;
+    bool append_to(std::string& buffer, bool pretty = false) const;
+    bool write_to(rapidjson::StringBuffer& buffer, bool pretty = false) const;
+    bool write_to(std::ostream& os, bool pretty = false) const;
+    bool write_to_file(const std::string& path, bool pretty = false) const;
+    bool write_to_file(const std::string& path, const SaveOptions& options) const;
+
     ValueRef get_value_ref() const;
+
+    /// opt-in hash index for wide objects, built lazily on first lookup when size() >= threshold.
+    /// lookups through this ObjectRef ( and its copies ) become O(1), JSON order is unchanged.
+    /// insert updates the index, erase and clear invalidate it.
+    /// modify the object through indexed ObjectRef, the index is not thread safe.
+    void enable_index(size_t threshold = detail::MemberIndex::DEFAULT_THRESHOLD);
+    void disable_index();
+    bool indexed() const { return static_cast<bool>(index_); }
+
 protected:
+    /// index lookup, or linear scan comparing length, first byte, then bytes
+    rapidjson::Value::MemberIterator find_member(const Key& key) const;
+    rapidjson::Value::MemberIterator find_member(const string_view& name) const;
+
+    /// keep index in sync after AddMember / EraseMember
+    void on_added() const;
+    void on_erased() const;
+
     ValueRef valueRef_;
+    std::shared_ptr<detail::MemberIndex> index_;
 };
 
 } // namespace wrapidjson
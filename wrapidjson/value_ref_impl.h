@@ -1,5 +1,10 @@
+#include "container.h"
+#include "element.h"
+#include "file_writer.h"
 #include "format.h"
 #include "parse.h"
+#include "stats.h"
+#include "writer.h"
 
 namespace wrapidjson {
 
@@ -7,7 +12,7 @@ namespace wrapidjson {
 /// ValueRef for rapidjson::value
 /////////////////////////////////////////////////////////////////////////////////////////////
 inline ValueRef::ValueRef(rapidjson::Value& value, rapidjson::Document::AllocatorType& alloc)
-    : value_(value), alloc_(alloc)
+    : value_(&value), alloc_(&alloc)
 {}
 inline ValueRef::ValueRef(const ValueRef& rfs)
     : value_(rfs.value_), alloc_(rfs.alloc_)
@@ -23,24 +28,55 @@ inline ValueRef::ValueRef(const ObjectRef& obj)
 /// copy assignment
 inline ValueRef& ValueRef::operator=(const ValueRef& other) {
     if (this != &other) {
-        value_.CopyFrom(other.value_, alloc_); // copy value explicitly
+        value_->CopyFrom(*other.value_, *alloc_); // copy value explicitly
+        detail::stats::deep_copy();
     }
     return *this;
 }
 
+/// move / swap ( O(1) on shared allocator )
+inline ValueRef& ValueRef::move_from(ValueRef other) {
+    if (value_ == other.value_) {
+        return *this;
+    }
+    if (shares_allocator(other)) {
+        *value_ = *other.value_;        // rapidjson assignment moves, other becomes Null
+    } else {
+        value_->CopyFrom(*other.value_, *alloc_);
+        other.value_->SetNull();
+        detail::stats::deep_copy();
+    }
+    return *this;
+}
+
+inline void ValueRef::swap(ValueRef other) {
+    if (value_ == other.value_) {
+        return;
+    }
+    if (shares_allocator(other)) {
+        value_->Swap(*other.value_);
+    } else {
+        rapidjson::Value temp(*other.value_, *alloc_);
+        other.value_->CopyFrom(*value_, *other.alloc_);
+        value_->Swap(temp);
+        detail::stats::deep_copy();
+        detail::stats::deep_copy();
+    }
+}
+
 /// catches std::string (makes a copy):
 inline ValueRef& ValueRef::operator=(const std::string& s) {
-    value_.SetString(s.data(), s.length(), alloc_); // make copy via allocator!
+    value_->SetString(s.data(), s.length(), *alloc_); // make copy via allocator!
     return *this;
 }
 
 inline ValueRef& ValueRef::operator=(const char* s) {
-    value_.SetString(s, alloc_); // make copy via allocator!
+    value_->SetString(s, *alloc_); // make copy via allocator!
     return *this;
 }
 
 inline ValueRef& ValueRef::operator=(const string_view& s) {
-    value_.SetString(s.data(), s.length());
+    value_->SetString(s.data(), s.length());
     return *this;
 }
 
@@ -57,15 +93,15 @@ inline ValueRef& ValueRef::operator=(const ObjectRef& object)
 
 /// set to empty Array
 inline ArrayRef ValueRef::set_array() {
-    value_.SetArray();
+    value_->SetArray();
     return ArrayRef(*this);
 }
 
 /// set to empty Array
 inline void ValueRef::push_back(const ValueRef& value) {
-    if ( value_.IsNull()) {
-        value_.SetArray();
-    } else if ( not value_.IsArray() ) {
+    if ( value_->IsNull()) {
+        value_->SetArray();
+    } else if ( not value_->IsArray() ) {
         throw std::runtime_error("ValueRef::push_back allow only ArrayType");
     }
     ArrayRef(*this).push_back(value);
@@ -73,24 +109,24 @@ inline void ValueRef::push_back(const ValueRef& value) {
 
 /// set to empty Array
 inline ValueRef ValueRef::operator[](size_t idx) const {
-    if ( not value_.IsArray() ) {
+    if ( not value_->IsArray() ) {
         throw std::runtime_error(detail::format("ValueRef[%u] allow only ArrayType", idx));
-    } else if (idx >= value_.Size() ) {
-        throw std::runtime_error(detail::format("ValueRef[%u] out_of_range(%u)", idx, value_.Size()));
+    } else if (idx >= value_->Size() ) {
+        throw std::runtime_error(detail::format("ValueRef[%u] out_of_range(%u)", idx, value_->Size()));
     }
     return ArrayRef(*this)[idx];
 }
 
 inline ObjectRef ValueRef::set_object() {
-    value_.SetObject();
+    value_->SetObject();
     return ObjectRef(*this);
 }
 
 /// set to Object
 inline ValueRef ValueRef::operator[](const char* name) const {
-    if ( value_.IsNull() ) {
-        value_.SetObject();
-    } else if (not value_.IsObject()) {
+    if ( value_->IsNull() ) {
+        value_->SetObject();
+    } else if (not value_->IsObject()) {
         throw std::runtime_error(detail::format("ValueRef[%s] allow ObjectType", name));
     }
     return ObjectRef(*this)[name];
@@ -100,23 +136,76 @@ inline ValueRef ValueRef::operator[](const std::string& name) const {
     return this->operator[](name.c_str());
 }
 /// check member
-inline bool ValueRef::has(const std::string& name) const {
-    if (value_.IsObject()) {
+inline bool ValueRef::has(const string_view& name) const {
+    if (value_->IsObject()) {
         return ObjectRef(*this).has(name);
     }
     return false;
 }
 /// find member
-inline optional<ValueRef> ValueRef::find(const std::string& name) const {
+inline optional<ValueRef> ValueRef::find(const string_view& name) const {
     optional<ValueRef> ret;
-    if ( value_.IsObject() ) {
+    if ( value_->IsObject() ) {
         ret = ObjectRef(*this).find(name);
     }
     return ret;
 }
 
+/// Key lookups
+inline ValueRef ValueRef::operator[](const Key& key) const {
+    if ( value_->IsNull() ) {
+        value_->SetObject();
+    } else if (not value_->IsObject()) {
+        throw std::runtime_error(detail::format("ValueRef[%s] allow ObjectType", key.str()));
+    }
+    return ObjectRef(*this)[key];
+}
+inline bool ValueRef::has(const Key& key) const {
+    if (value_->IsObject()) {
+        return ObjectRef(*this).has(key);
+    }
+    return false;
+}
+inline optional<ValueRef> ValueRef::find(const Key& key) const {
+    optional<ValueRef> ret;
+    if ( value_->IsObject() ) {
+        ret = ObjectRef(*this).find(key);
+    }
+    return ret;
+}
+
+/// non throwing lookups
+inline Expected<ValueRef> ValueRef::try_at(size_t idx) const {
+    if ( not value_->IsArray() ) {
+        return ErrorCode::NOT_ARRAY;
+    } else if ( idx >= value_->Size() ) {
+        return ErrorCode::OUT_OF_RANGE;
+    }
+    return ValueRef((*value_)[static_cast<rapidjson::SizeType>(idx)], *alloc_);
+}
+inline Expected<ValueRef> ValueRef::try_at(const string_view& name) const {
+    if ( not value_->IsObject() ) {
+        return ErrorCode::NOT_OBJECT;
+    }
+    auto found = ObjectRef(*this).find(name);
+    if ( not found ) {
+        return ErrorCode::NO_MEMBER;
+    }
+    return *found;
+}
+inline Expected<ValueRef> ValueRef::try_at(const Key& key) const {
+    if ( not value_->IsObject() ) {
+        return ErrorCode::NOT_OBJECT;
+    }
+    auto found = ObjectRef(*this).find(key);
+    if ( not found ) {
+        return ErrorCode::NO_MEMBER;
+    }
+    return *found;
+}
+
 inline rapidjson::Value& ValueRef::get_rvalue() const {
-    return value_;
+    return *value_;
 }
 inline ValueRef ValueRef::get_ref() const {
     return *this;
@@ -129,69 +218,100 @@ inline ObjectRef ValueRef::get_object() const {
 }
 
 inline bool ValueRef::empty() const {
-    if ( value_.IsObject() ) {
-        return value_.ObjectEmpty();
-    } else if ( value_.IsArray() ) {
-        return value_.Empty();
-    } else if ( value_.IsString() ) {
-        return value_.GetStringLength() == 0;
+    if ( value_->IsObject() ) {
+        return value_->ObjectEmpty();
+    } else if ( value_->IsArray() ) {
+        return value_->Empty();
+    } else if ( value_->IsString() ) {
+        return value_->GetStringLength() == 0;
     }
     return false;
 }
 
 inline size_t ValueRef::size() const {
-    if ( value_.IsObject() ) {
-        return value_.MemberCount();
-    } else if ( value_.IsArray() ) {
-        return value_.Size();
-    } else if ( value_.IsString() ) {
-        return value_.GetStringLength();
+    if ( value_->IsObject() ) {
+        return value_->MemberCount();
+    } else if ( value_->IsArray() ) {
+        return value_->Size();
+    } else if ( value_->IsString() ) {
+        return value_->GetStringLength();
     }
     return 0;
 }
 
+/// serialize referenced value
+inline std::string ValueRef::to_string(bool pretty) const {
+    std::string str;
+    detail::write_value(*value_, str, pretty);
+    return str;
+}
+
+inline bool ValueRef::write_to(std::string& buffer, bool pretty) const {
+    return detail::write_value(*value_, buffer, pretty);
+}
+
+inline bool ValueRef::append_to(std::string& buffer, bool pretty) const {
+    return detail::append_value(*value_, buffer, pretty);
+}
+
+inline bool ValueRef::write_to(rapidjson::StringBuffer& buffer, bool pretty) const {
+    return detail::write_value(*value_, buffer, pretty);
+}
+
+inline bool ValueRef::write_to(std::ostream& os, bool pretty) const {
+    return detail::write_value(*value_, os, pretty);
+}
+
+inline bool ValueRef::write_to_file(const std::string& path, bool pretty) const {
+    return detail::write_value_to_file(*value_, path, pretty);
+}
+
+inline bool ValueRef::write_to_file(const std::string& path, const SaveOptions& options) const {
+    return detail::write_value_to_file(*value_, path, options);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// ValueRef::as tempalte impl
 /// type = as<type> 인터페이스
 /////////////////////////////////////////////////////////////////////////////////////////////
 template<typename T, detail::enable_if_num_t<T>*>
 inline T ValueRef::as() const {
-    if (value_.IsNumber()) {
-        if (value_.IsInt()) {
-            return static_cast<T>(value_.GetInt());
-        } else if (value_.IsUint()) {
-            return static_cast<T>(value_.GetUint());
-        } else if (value_.IsInt64()) {
-            return static_cast<T>(value_.GetInt64());
-        } else if (value_.IsUint64()) {
-            return static_cast<T>(value_.GetUint64());
-        } else if (value_.IsDouble()) {
-            return static_cast<T>(value_.GetDouble());
+    if (value_->IsNumber()) {
+        if (value_->IsInt()) {
+            return static_cast<T>(value_->GetInt());
+        } else if (value_->IsUint()) {
+            return static_cast<T>(value_->GetUint());
+        } else if (value_->IsInt64()) {
+            return static_cast<T>(value_->GetInt64());
+        } else if (value_->IsUint64()) {
+            return static_cast<T>(value_->GetUint64());
+        } else if (value_->IsDouble()) {
+            return static_cast<T>(value_->GetDouble());
         }
-    } else if (value_.IsBool()) {
-        return static_cast<T>(value_.GetBool());
-    } else if (value_.IsString()) {
-        return detail::parse<T>(value_.GetString(),0);
+    } else if (value_->IsBool()) {
+        return static_cast<T>(value_->GetBool());
+    } else if (value_->IsString()) {
+        return detail::parse<T>(string_view(value_->GetString(), value_->GetStringLength()), 0);
     }
     return 0;
 }
 
 template<typename T, detail::enable_if_char_t<T>*>
 inline char ValueRef::as() const {
-    if (value_.IsNumber()) {
-        if (value_.IsInt()) {
-            return static_cast<char>(value_.GetInt());
-        } else if (value_.IsUint()) {
-            return static_cast<char>(value_.GetUint());
-        } else if (value_.IsInt64()) {
-            return static_cast<char>(value_.GetInt64());
-        } else if (value_.IsUint64()) {
-            return static_cast<char>(value_.GetUint64());
-        } else if (value_.IsDouble()) {
-            return static_cast<char>(value_.GetDouble());
+    if (value_->IsNumber()) {
+        if (value_->IsInt()) {
+            return static_cast<char>(value_->GetInt());
+        } else if (value_->IsUint()) {
+            return static_cast<char>(value_->GetUint());
+        } else if (value_->IsInt64()) {
+            return static_cast<char>(value_->GetInt64());
+        } else if (value_->IsUint64()) {
+            return static_cast<char>(value_->GetUint64());
+        } else if (value_->IsDouble()) {
+            return static_cast<char>(value_->GetDouble());
         }
-    } else if (value_.IsString() and value_.GetStringLength() > 0) {
-        return value_.GetString()[0];
+    } else if (value_->IsString() and value_->GetStringLength() > 0) {
+        return value_->GetString()[0];
     }
     return ' ';
 }
@@ -199,34 +319,42 @@ inline char ValueRef::as() const {
 
 template<typename T, detail::enable_if_cptr_t<T>*>
 inline const char* ValueRef::as() const {
-    if (value_.IsString()) {
-        return value_.GetString();
+    if (value_->IsString()) {
+        return value_->GetString();
     }
     return nullptr;
 }
 
 template<typename T, detail::enable_if_str_t<T>*>
 inline std::string ValueRef::as() const {
-    if (value_.IsNumber()) {
-        if (value_.IsInt()) {
-            return std::to_string(value_.GetInt());
-        } else if (value_.IsUint()) {
-            return std::to_string(value_.GetUint());
-        } else if (value_.IsInt64()) {
-            return std::to_string(value_.GetInt64());
-        } else if (value_.IsUint64()) {
-            return std::to_string(value_.GetUint64());
-        } else if (value_.IsDouble()) {
-            return std::to_string(value_.GetDouble());
+    if (value_->IsNumber()) {
+        if (value_->IsInt()) {
+            return std::to_string(value_->GetInt());
+        } else if (value_->IsUint()) {
+            return std::to_string(value_->GetUint());
+        } else if (value_->IsInt64()) {
+            return std::to_string(value_->GetInt64());
+        } else if (value_->IsUint64()) {
+            return std::to_string(value_->GetUint64());
+        } else if (value_->IsDouble()) {
+            return detail::format_double(value_->GetDouble());
         }
-    } else if (value_.IsBool()) {
-        return (value_.GetBool() ? "true" : "false");
-    } else if (value_.IsString()) {
-        return value_.GetString();
+    } else if (value_->IsBool()) {
+        return (value_->GetBool() ? "true" : "false");
+    } else if (value_->IsString()) {
+        return std::string(value_->GetString(), value_->GetStringLength());
     }
     return "";
 }
 
+template<typename T, detail::enable_if_sv_t<T>*>
+inline string_view ValueRef::as() const {
+    if (value_->IsString()) {
+        return string_view(value_->GetString(), value_->GetStringLength());
+    }
+    return string_view();
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// ValueRef::get tempalte impl
 /// optional<type> = get<type> 인터페이스
@@ -234,8 +362,8 @@ inline std::string ValueRef::as() const {
 template<typename T, detail::enable_if_bool_t<T>*>
 inline optional<bool> ValueRef::get() const {
     optional<bool> res;
-    if ( value_.IsBool() ) {
-        res = value_.GetBool();
+    if ( value_->IsBool() ) {
+        res = value_->GetBool();
     }
     return res;
 }
@@ -243,8 +371,8 @@ inline optional<bool> ValueRef::get() const {
 template<typename T, detail::enable_if_char_t<T>*>
 inline optional<char> ValueRef::get() const {
     optional<char> res;
-    if (value_.IsString() && value_.GetStringLength() == 1) {
-        res = value_.GetString()[0];
+    if (value_->IsString() && value_->GetStringLength() == 1) {
+        res = value_->GetString()[0];
     }
     return res;
 }
@@ -252,8 +380,8 @@ inline optional<char> ValueRef::get() const {
 template<typename T, detail::enable_if_int64_t<T>*>
 inline optional<T> ValueRef::get() const {
     optional<T> res;
-    if ( value_.IsInt64() ) {
-        res = static_cast<T>(value_.GetInt64());
+    if ( value_->IsInt64() ) {
+        res = static_cast<T>(value_->GetInt64());
     }
     return res;
 }
@@ -261,10 +389,10 @@ inline optional<T> ValueRef::get() const {
 template<typename T, detail::enable_if_int_t<T>*>
 inline optional<T> ValueRef::get() const {
     optional<T> res;
-    if ( value_.IsInt() and
-            value_.GetInt() >= std::numeric_limits<T>::min() and
-            value_.GetInt() <= std::numeric_limits<T>::max() ) {
-        res = static_cast<T>(value_.GetInt());
+    if ( value_->IsInt() and
+            value_->GetInt() >= std::numeric_limits<T>::min() and
+            value_->GetInt() <= std::numeric_limits<T>::max() ) {
+        res = static_cast<T>(value_->GetInt());
     }
     return res;
 }
@@ -272,8 +400,8 @@ inline optional<T> ValueRef::get() const {
 template<typename T, detail::enable_if_uint64_t<T>*>
 inline optional<T> ValueRef::get() const {
     optional<T> res;
-    if ( value_.IsUint64() ) {
-        res = static_cast<T>(value_.GetUint64());
+    if ( value_->IsUint64() ) {
+        res = static_cast<T>(value_->GetUint64());
     }
     return res;
 }
@@ -281,10 +409,10 @@ inline optional<T> ValueRef::get() const {
 template<typename T, detail::enable_if_uint_t<T>*>
 inline optional<T> ValueRef::get() const {
     optional<T> res;
-    if ( value_.IsUint() and
-            value_.GetUint() >= std::numeric_limits<T>::min() and
-             value_.GetUint() <= std::numeric_limits<T>::max() ) {
-        res = static_cast<T>(value_.GetUint());
+    if ( value_->IsUint() and
+            value_->GetUint() >= std::numeric_limits<T>::min() and
+             value_->GetUint() <= std::numeric_limits<T>::max() ) {
+        res = static_cast<T>(value_->GetUint());
     }
     return res;
 }
@@ -292,8 +420,8 @@ inline optional<T> ValueRef::get() const {
 template<typename T, detail::enable_if_float_t<T>*>
 inline optional<T> ValueRef::get() const {
     optional<T> res;
-    if (value_.IsNumber()) {
-        res = static_cast<T>(value_.GetDouble());
+    if (value_->IsNumber()) {
+        res = static_cast<T>(value_->GetDouble());
     }
     return res;
 }
@@ -301,8 +429,8 @@ inline optional<T> ValueRef::get() const {
 template<typename T, detail::enable_if_cptr_t<T>*>
 inline optional<const char*> ValueRef::get() const {
     optional<const char*> res;
-    if (value_.IsString()) {
-        res = value_.GetString();
+    if (value_->IsString()) {
+        res = value_->GetString();
     }
     return res;
 }
@@ -310,207 +438,71 @@ inline optional<const char*> ValueRef::get() const {
 template<typename T, detail::enable_if_str_t<T>*>
 inline optional<std::string> ValueRef::get() const {
     optional<std::string> res;
-    if (value_.IsString()) {
-        res = std::string(value_.GetString(), value_.GetStringLength());
+    if (value_->IsString()) {
+        res = std::string(value_->GetString(), value_->GetStringLength());
     }
     return res;
 }
 
-/////////////////////////////////////////////////////////////////////////////////////////////
-/// ValueRef::set_container tempalte impl
-/////////////////////////////////////////////////////////////////////////////////////////////
-
-/// set Container ( Container<Number> )
-template<typename T, template <typename...> class Container, typename...Args, 
-    detail::enable_if_sequence_t<T, Container, Args...>*
->
-inline void ValueRef::set_container(const Container<T, Args...>& array, bool str_copy)
-{
-    (void)str_copy;
-    value_.SetArray();
-    value_.Reserve(array.size(), alloc_);
-    for (auto& k : array) {
-        value_.PushBack(rapidjson::Value(k), alloc_);
-    }
-}
-
-
-/// set Container ( Continaer<String> )
-template<template <typename...> class Container, typename...Args,
-    detail::enable_if_sequence_t<std::string, Container, Args...>*
->
-inline void ValueRef::set_container(const Container<std::string, Args...>& array, bool str_copy)
-{
-    value_.SetArray();
-    value_.Reserve(array.size(), alloc_);
-    for (auto& k : array) {
-        if ( str_copy ) {
-            value_.PushBack(rapidjson::Value(k.data(), k.length(), alloc_), alloc_);    // string copy
-        } else {
-            value_.PushBack(rapidjson::Value(k.data(), k.length()), alloc_);            // string not copy
-        }
-    }
-}
-
-/// assing from map<string, T>
-template<typename T, template <typename...> class Container, typename...Args,
-    detail::enable_if_strmap_t<T, Container, Args...>*
->
-inline void ValueRef::set_container(const Container<std::string, T, Args...>& map, bool str_copy)
-{
-    value_.SetObject();
-    for (auto& k : map){
-        rapidjson::Value name;
-        if ( str_copy ) {
-            name.SetString(k.first.data(), k.first.length(), alloc_);
-        } else {
-            name.SetString(k.first.data(), k.first.length());
-        }
-        rapidjson::Value value(k.second);
-        value_.AddMember(name.Move(), value.Move(), alloc_);
-    }
-}
-
-/// assign from map<string, string>
-template<template <typename...> class Container, typename ...Args,
-    detail::enable_if_strmap_t<std::string, Container, Args...>*
->
-inline void ValueRef::set_container(const Container<std::string, std::string>& map, bool str_copy)
-{
-    value_.SetObject();
-    for (auto& k : map){
-        rapidjson::Value name, value;
-        if ( str_copy ) {
-            name.SetString(k.first.data(), k.first.length(), alloc_);
-            value.SetString(k.second.data(), k.second.length(), alloc_);
-        } else {
-            name.SetString(k.first.data(), k.first.length());
-            value.SetString(k.second.data(), k.second.length());
-        }
-        value_.AddMember(name.Move(), value.Move(), alloc_);
-    }
-}
-
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// long != rapidjson::SizeType(int64_t)
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// set Container ( Container<long> )
-template<template <typename...> class Container, typename...Args, detail::enable_if_l_sequence_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<long, Args...>& array, bool str_copy)
-{
-    (void)str_copy;
-    value_.SetArray();
-    value_.Reserve(array.size(), alloc_);
-    for (auto& k : array) {
-        value_.PushBack(rapidjson::Value(static_cast<int64_t>(k)), alloc_);
-    }
-}
-
-/// set Container ( Container<unsigned long> )
-template<template <typename...> class Container, typename...Args, detail::enable_if_ul_sequence_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<unsigned long, Args...>& array, bool str_copy)
-{
-    (void)str_copy;
-    value_.SetArray();
-    value_.Reserve(array.size(), alloc_);
-    for (auto& k : array) {
-        value_.PushBack(rapidjson::Value(static_cast<uint64_t>(k)), alloc_);
+template<typename T, detail::enable_if_sv_t<T>*>
+inline optional<string_view> ValueRef::get() const {
+    optional<string_view> res;
+    if (value_->IsString()) {
+        res = string_view(value_->GetString(), value_->GetStringLength());
     }
+    return res;
 }
 
-/// assign from map<string, long>
-template<template <typename...> class Container, typename...Args, detail::enable_if_str_l_map_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<std::string, long, Args...>& map, bool str_copy)
-{
-    value_.SetObject();
-    for (auto& k : map){
-        rapidjson::Value name;
-        if ( str_copy ) {
-            name.SetString(k.first.data(), k.first.length(), alloc_);
-        } else {
-            name.SetString(k.first.data(), k.first.length());
-        }
-        rapidjson::Value value(static_cast<int64_t>(k.second));
-        value_.AddMember(name.Move(), value.Move(), alloc_);
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// ValueRef::try_get tempalte impl
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+inline Expected<T> ValueRef::try_get() const {
+    auto value = get<T>();
+    if ( not value ) {
+        return ErrorCode::TYPE_MISMATCH;
     }
+    return *value;
 }
 
-/// assign from map<string, unsigned long>
-template<template <typename...> class Container, typename...Args, detail::enable_if_str_ul_map_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<std::string, unsigned long, Args...>& map, bool str_copy)
-{
-    value_.SetObject();
-    for (auto& k : map){
-        rapidjson::Value name;
-        if ( str_copy ) {
-            name.SetString(k.first.data(), k.first.length(), alloc_);
-        } else {
-            name.SetString(k.first.data(), k.first.length());
-        }
-        rapidjson::Value value(static_cast<uint64_t>(k.second));
-        value_.AddMember(name.Move(), value.Move(), alloc_);
+template<typename T>
+inline Expected<T> ValueRef::try_get(const string_view& name) const {
+    auto member = try_at(name);
+    if ( not member ) {
+        return member.error();
     }
+    return member->try_get<T>();
 }
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// long long != rapidjson::SizeType(int64_t)
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// set Container ( Container<long long> )
-template<template <typename...> class Container, typename...Args, detail::enable_if_ll_sequence_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<long long, Args...>& array, bool str_copy)
-{
-    (void)str_copy;
-    value_.SetArray();
-    value_.Reserve(array.size(), alloc_);
-    for (auto& k : array) {
-        value_.PushBack(rapidjson::Value(static_cast<int64_t>(k)), alloc_);
+template<typename T>
+inline Expected<T> ValueRef::try_get(const Key& key) const {
+    auto member = try_at(key);
+    if ( not member ) {
+        return member.error();
     }
+    return member->try_get<T>();
 }
 
-/// set Container ( Container<unsigned long long> )
-template<template <typename...> class Container, typename...Args, detail::enable_if_ull_sequence_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<unsigned long long, Args...>& array, bool str_copy)
-{
-    (void)str_copy;
-    value_.SetArray();
-    value_.Reserve(array.size(), alloc_);
-    for (auto& k : array) {
-        value_.PushBack(rapidjson::Value(static_cast<uint64_t>(k)), alloc_);
-    }
-}
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// ValueRef::set_container tempalte impl
+/////////////////////////////////////////////////////////////////////////////////////////////
 
-/// assign from map<string, long long>
-template<template <typename...> class Container, typename...Args, detail::enable_if_str_ll_map_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<std::string, long long, Args...>& map, bool str_copy)
+/// set Container ( Container<T> -> Array )
+template<typename T, template <typename...> class Container, typename...Args,
+    detail::enable_if_sequence_t<T, Container, Args...>*
+>
+inline void ValueRef::set_container(const Container<T, Args...>& array, bool str_copy)
 {
-    value_.SetObject();
-    for (auto& k : map){
-        rapidjson::Value name;
-        if ( str_copy ) {
-            name.SetString(k.first.data(), k.first.length(), alloc_);
-        } else {
-            name.SetString(k.first.data(), k.first.length());
-        }
-        rapidjson::Value value(static_cast<int64_t>(k.second));
-        value_.AddMember(name.Move(), value.Move(), alloc_);
-    }
+    detail::container_value<Container<T, Args...>>::assign(*value_, array, *alloc_, str_copy);
 }
 
-/// assign from map<string, unsigned long long>
-template<template <typename...> class Container, typename...Args, detail::enable_if_str_ull_map_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<std::string, unsigned long long, Args...>& map, bool str_copy)
+/// assing from map<string, T>
+template<typename T, template <typename...> class Container, typename...Args,
+    detail::enable_if_strmap_t<T, Container, Args...>*
+>
+inline void ValueRef::set_container(const Container<std::string, T, Args...>& map, bool str_copy)
 {
-    value_.SetObject();
-    for (auto& k : map){
-        rapidjson::Value name;
-        if ( str_copy ) {
-            name.SetString(k.first.data(), k.first.length(), alloc_);
-        } else {
-            name.SetString(k.first.data(), k.first.length());
-        }
-        rapidjson::Value value(static_cast<uint64_t>(k.second));
-        value_.AddMember(name.Move(), value.Move(), alloc_);
-    }
+    detail::container_value<Container<std::string, T, Args...>>::assign(*value_, map, *alloc_, str_copy);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -542,9 +534,9 @@ inline ArrayRef::ArrayRef(const ArrayRef& rfs)
 inline ArrayRef::ArrayRef(const ValueRef& value)
     : valueRef_(value)
 {
-    if ( valueRef_.value_.IsNull() ) {
-        valueRef_.value_.SetArray();
-    } else if ( not valueRef_.value_.IsArray() ) {
+    if ( valueRef_.value_->IsNull() ) {
+        valueRef_.value_->SetArray();
+    } else if ( not valueRef_.value_->IsArray() ) {
         throw std::runtime_error("Value is not arrayType, ArrayRef must derived by arrayType");
     }
 }
@@ -565,26 +557,26 @@ inline void ArrayRef::set_container(const Container<T, Args...>& array, bool str
 }
 
 inline ValueRef ArrayRef::operator[](size_t index) const {
-    if ( index >= valueRef_.value_.Size() ) {
+    if ( index >= valueRef_.value_->Size() ) {
         throw std::runtime_error("Array index out_of_range");
     }
-    return ValueRef(valueRef_.value_[index], valueRef_.alloc_);
+    return ValueRef((*valueRef_.value_)[index], *valueRef_.alloc_);
 }
 
 inline size_t ArrayRef::size() const {
-    return valueRef_.value_.Size();
+    return valueRef_.value_->Size();
 }
 
 inline bool ArrayRef::empty() const {
-    return valueRef_.value_.Empty();
+    return valueRef_.value_->Empty();
 }
 
 inline size_t ArrayRef::capacity() const {
-    return valueRef_.value_.Capacity();
+    return valueRef_.value_->Capacity();
 }
 
 inline void ArrayRef::reserve(size_t n) {
-    valueRef_.value_.Reserve(n, valueRef_.alloc_);
+    valueRef_.value_->Reserve(n, *valueRef_.alloc_);
 }
 
 inline void ArrayRef::resize(size_t n) {
@@ -592,12 +584,12 @@ inline void ArrayRef::resize(size_t n) {
     reserve(n);
     if (diff > 0) {
         for (int i = 0; i < diff; ++i) {
-            valueRef_.value_.PushBack(rapidjson::Value(), valueRef_.alloc_);
+            valueRef_.value_->PushBack(rapidjson::Value(), *valueRef_.alloc_);
         }
     } else if (diff < 0) {
         diff *= -1;
         for (int i = 0; i < diff; ++i) {
-            valueRef_.value_.PopBack();
+            valueRef_.value_->PopBack();
         }
     }
 }
@@ -609,48 +601,80 @@ inline void ArrayRef::resize(size_t n, T&& value) {
     if (diff > 0) {
         for (int i = 0; i < diff; ++i) {
             rapidjson::Value temp;
-            ValueRef dummy(temp, valueRef_.alloc_);
+            ValueRef dummy(temp, *valueRef_.alloc_);
             dummy = std::forward<T>(value);
-            valueRef_.value_.PushBack(temp.Move(), valueRef_.alloc_);
+            valueRef_.value_->PushBack(temp.Move(), *valueRef_.alloc_);
         }
     } else if (diff < 0) {
         diff *= -1;
         for (int i = 0; i < diff; ++i) {
-            valueRef_.value_.PopBack();
+            valueRef_.value_->PopBack();
         }
     }
 }
 
 inline void ArrayRef::clear() {
-    valueRef_.value_.Clear();
+    valueRef_.value_->Clear();
 }
 
 inline ValueIterator ArrayRef::begin() const {
-    return ValueIterator(valueRef_.value_.Begin(), valueRef_.alloc_);
+    return ValueIterator(valueRef_.value_->Begin(), *valueRef_.alloc_);
 }
 
 inline ValueIterator ArrayRef::end() const {
-    return ValueIterator(valueRef_.value_.End(), valueRef_.alloc_);
+    return ValueIterator(valueRef_.value_->End(), *valueRef_.alloc_);
 }
 
 inline ValueRef ArrayRef::front() const {
-    if ( valueRef_.value_.Empty() ) {
+    if ( valueRef_.value_->Empty() ) {
         throw std::runtime_error("Empty Array front() is null");
     }
-    return ValueRef(valueRef_.value_[0], valueRef_.alloc_);
+    return ValueRef((*valueRef_.value_)[0], *valueRef_.alloc_);
 }
 
 inline ValueRef ArrayRef::back() const {
-    if ( valueRef_.value_.Empty() ) {
+    if ( valueRef_.value_->Empty() ) {
         throw std::runtime_error("Empty Array back() is null");
     }
-    return ValueRef(valueRef_.value_[size()-1], valueRef_.alloc_);
+    return ValueRef((*valueRef_.value_)[size()-1], *valueRef_.alloc_);
 }
 
 template <typename T>
 inline optional<std::vector<T>> ArrayRef::get_vector()
 {
     optional<std::vector<T>> result;
+    std::vector<T> res;
+    if ( get_vector(res) ) {
+        result.emplace(std::move(res));
+    }
+    return result;
+}
+
+template <typename T>
+inline bool ArrayRef::get_vector(std::vector<T>& out) const
+{
+    return get_elements(out, detail::is_bulk_element<T>());
+}
+
+template <typename T>
+inline bool ArrayRef::get_elements(std::vector<T>& out, std::true_type) const
+{
+    const rapidjson::Value& array = *valueRef_.value_;
+    for (auto it = array.Begin(); it != array.End(); ++it) {
+        if ( not detail::element<T>::is(*it) ) {
+            return false;
+        }
+    }
+    out.resize(array.Size());
+    for (rapidjson::SizeType i = 0; i < array.Size(); ++i) {
+        out[i] = detail::element<T>::get(array[i]);
+    }
+    return true;
+}
+
+template <typename T>
+inline bool ArrayRef::get_elements(std::vector<T>& out, std::false_type) const
+{
     std::vector<T> res;
     res.reserve(size());
     for (const auto& value : *this)
@@ -659,10 +683,40 @@ inline optional<std::vector<T>> ArrayRef::get_vector()
         if ( value_ ) {
             res.emplace_back(std::move(*value_));
         } else {
-            return result;
+            return false;
+        }
+    }
+    out.swap(res);
+    return true;
+}
+
+template <typename T>
+inline bool ArrayRef::copy_to(T* out, size_t n) const
+{
+    static_assert(detail::element<T>::bulk, "copy_to requires arithmetic element type");
+    const rapidjson::Value& array = *valueRef_.value_;
+    if ( n < array.Size() ) {
+        return false;
+    }
+    for (auto it = array.Begin(); it != array.End(); ++it) {
+        if ( not detail::element<T>::is(*it) ) {
+            return false;
         }
     }
-    result = res;
+    for (auto it = array.Begin(); it != array.End(); ++it) {
+        *out++ = detail::element<T>::get(*it);
+    }
+    return true;
+}
+
+template <typename T>
+inline std::vector<T> ArrayRef::as_vector()
+{
+    std::vector<T> result;
+    result.reserve(size());
+    for (auto& value : valueRef_.value_->GetArray()) {
+        result.emplace_back(ValueRef(value, *valueRef_.alloc_).as<T>());
+    }
     return result;
 }
 
@@ -684,28 +738,139 @@ inline std::vector<T> ArrayRef::as_vector(std::function<bool(const T&)> func)
 template<typename T>
 inline void ArrayRef::push_back(T&& value) {
     rapidjson::Value temp;
-    ValueRef dummy(temp, valueRef_.alloc_);
+    ValueRef dummy(temp, *valueRef_.alloc_);
     dummy = std::forward<T>(value);
-    valueRef_.value_.PushBack(temp.Move(), valueRef_.alloc_);
+    valueRef_.value_->PushBack(temp.Move(), *valueRef_.alloc_);
+}
+
+template<typename T>
+inline void ArrayRef::append(const T* data, size_t n) {
+    static_assert(detail::element<T>::bulk, "append requires arithmetic element type");
+    rapidjson::Value& array = *valueRef_.value_;
+    array.Reserve(static_cast<rapidjson::SizeType>(array.Size() + n), *valueRef_.alloc_);
+    for (size_t i = 0; i < n; ++i) {
+        array.PushBack(detail::element<T>::make(data[i]), *valueRef_.alloc_);
+    }
+}
+
+template <typename... Ts>
+inline bool ArrayRef::get_columns(const Column<Ts>&... columns) const {
+    std::tuple<Column<Ts>...> cols(columns...);
+    size_t hints[sizeof...(Ts) + 1] = {};
+    rapidjson::Value& array = *valueRef_.value_;
+    clear_columns<0>(cols, array.Size());
+    for (auto it = array.Begin(); it != array.End(); ++it) {
+        if ( not it->IsObject() or not get_row<0>(*it, cols, hints) ) {
+            clear_columns<0>(cols, 0);
+            return false;
+        }
+    }
+    return true;
+}
+
+template <size_t I, typename Tuple>
+inline detail::enable_if_t<(I < std::tuple_size<Tuple>::value), bool>
+ArrayRef::get_row(rapidjson::Value& row, const Tuple& columns, size_t* hints) const {
+    const auto& col = std::get<I>(columns);
+    using T = typename std::decay<decltype(*col.out)>::type::value_type;
+    rapidjson::Value* value = detail::find_member_hint(row, col.key, hints[I]);
+    if ( value == nullptr or value->IsNull() ) {
+        if ( col.required ) {
+            return false;
+        }
+        col.out->push_back(T());
+    } else {
+        T cell;
+        if ( not get_element(*value, cell, detail::is_bulk_element<T>()) ) {
+            return false;
+        }
+        col.out->push_back(std::move(cell));
+    }
+    return get_row<I + 1>(row, columns, hints);
+}
+
+template <size_t I, typename Tuple>
+inline detail::enable_if_t<(I == std::tuple_size<Tuple>::value), bool>
+ArrayRef::get_row(rapidjson::Value&, const Tuple&, size_t*) const {
+    return true;
+}
+
+template <size_t I, typename Tuple>
+inline detail::enable_if_t<(I < std::tuple_size<Tuple>::value)>
+ArrayRef::clear_columns(const Tuple& columns, size_t reserve) const {
+    std::get<I>(columns).out->clear();
+    std::get<I>(columns).out->reserve(reserve);
+    clear_columns<I + 1>(columns, reserve);
+}
+
+template <size_t I, typename Tuple>
+inline detail::enable_if_t<(I == std::tuple_size<Tuple>::value)>
+ArrayRef::clear_columns(const Tuple&, size_t) const {}
+
+template <typename T>
+inline bool ArrayRef::get_element(rapidjson::Value& value, T& out, std::true_type) const {
+    if ( not detail::element<T>::is(value) ) {
+        return false;
+    }
+    out = detail::element<T>::get(value);
+    return true;
+}
+
+template <typename T>
+inline bool ArrayRef::get_element(rapidjson::Value& value, T& out, std::false_type) const {
+    auto res = ValueRef(value, *valueRef_.alloc_).get<T>();
+    if ( not res ) {
+        return false;
+    }
+    out = std::move(*res);
+    return true;
 }
 
 inline ValueRef ArrayRef::push_back() {
-    valueRef_.value_.PushBack(rapidjson::Value(), valueRef_.alloc_);
-    return ValueRef(valueRef_.value_[size()-1], valueRef_.alloc_);
+    valueRef_.value_->PushBack(rapidjson::Value(), *valueRef_.alloc_);
+    return ValueRef((*valueRef_.value_)[size()-1], *valueRef_.alloc_);
 }
 
 inline void ArrayRef::pop_back() {
-    if ( not valueRef_.value_.Empty() ) {
-        valueRef_.value_.PopBack();
+    if ( not valueRef_.value_->Empty() ) {
+        valueRef_.value_->PopBack();
     }
 }
 
 inline ValueIterator ArrayRef::erase(const ValueIterator& pos) {
-    return ValueIterator(valueRef_.value_.Erase(pos.ptr_), valueRef_.alloc_);
+    return ValueIterator(valueRef_.value_->Erase(pos.ptr_), *valueRef_.alloc_);
 }
 
 inline ValueIterator ArrayRef::erase(const ValueIterator& first, const ValueIterator& last) {
-    return ValueIterator(valueRef_.value_.Erase(first.ptr_, last.ptr_), valueRef_.alloc_);
+    return ValueIterator(valueRef_.value_->Erase(first.ptr_, last.ptr_), *valueRef_.alloc_);
+}
+
+inline std::string ArrayRef::to_string(bool pretty) const {
+    return valueRef_.to_string(pretty);
+}
+
+inline bool ArrayRef::write_to(std::string& buffer, bool pretty) const {
+    return valueRef_.write_to(buffer, pretty);
+}
+
+inline bool ArrayRef::append_to(std::string& buffer, bool pretty) const {
+    return valueRef_.append_to(buffer, pretty);
+}
+
+inline bool ArrayRef::write_to(rapidjson::StringBuffer& buffer, bool pretty) const {
+    return valueRef_.write_to(buffer, pretty);
+}
+
+inline bool ArrayRef::write_to(std::ostream& os, bool pretty) const {
+    return valueRef_.write_to(os, pretty);
+}
+
+inline bool ArrayRef::write_to_file(const std::string& path, bool pretty) const {
+    return valueRef_.write_to_file(path, pretty);
+}
+
+inline bool ArrayRef::write_to_file(const std::string& path, const SaveOptions& options) const {
+    return valueRef_.write_to_file(path, options);
 }
 
 inline ValueRef ArrayRef::get_value_ref() const {
@@ -716,22 +881,22 @@ inline ObjectRef::ObjectRef(const ValueRef& value)
     : valueRef_(value)
 {
     static const size_t STRING_MAX_SIZE = 15;
-    if ( valueRef_.value_.IsNull() ) {
-        valueRef_.value_.SetObject();
-    } else if ( not valueRef_.value_.IsObject() ) {
+    if ( valueRef_.value_->IsNull() ) {
+        valueRef_.value_->SetObject();
+    } else if ( not valueRef_.value_->IsObject() ) {
         throw std::runtime_error("Value is not ObjectType, ObjectRef must derived by ObjectType");
     }
 }
 
 inline ObjectRef::ObjectRef(const ObjectRef& rfs)
-    : valueRef_(rfs.valueRef_)
+    : valueRef_(rfs.valueRef_), index_(rfs.index_)
 {}
 
 template<typename T, template <typename...> class Container, typename...Args,
     detail::enable_if_strmap_t<T, Container>*
 >
 inline ObjectRef& ObjectRef::operator=(const Container<std::string, T, Args...>& map) {
-    valueRef_.set_container(map);
+    set_container(map);
     return *this;
 }
 
@@ -741,135 +906,243 @@ template<typename T, template <typename...> class Container, typename...Args,
 >
 inline void ObjectRef::set_container(const Container<std::string, T, Args...>& map, bool str_copy) {
     valueRef_.set_container(map, str_copy);
+    on_erased();
+}
+
+inline void ObjectRef::enable_index(size_t threshold) {
+    index_ = std::make_shared<detail::MemberIndex>(threshold);
+}
+
+inline void ObjectRef::disable_index() {
+    index_.reset();
+}
+
+inline rapidjson::Value::MemberIterator ObjectRef::find_member(const Key& key) const {
+    auto& value = *valueRef_.value_;
+    auto end = value.MemberEnd();
+    auto it = value.MemberBegin();
+    if (index_ and index_->enabled(value)) {
+        it = value.MemberBegin() + index_->find(value, key);
+    } else {
+        for (; it != end; ++it) {
+            if (key.equals(it->name.GetString(), it->name.GetStringLength())) {
+                break;
+            }
+        }
+    }
+    detail::stats::lookup(it != end);
+    return it;
+}
+
+inline rapidjson::Value::MemberIterator ObjectRef::find_member(const string_view& name) const {
+    if (index_ and index_->enabled(*valueRef_.value_)) {
+        return find_member(Key(name));  // hash only when indexed
+    }
+    auto it = valueRef_.value_->FindMember(rapidjson::Value(rapidjson::StringRef(name.data(), name.length())));
+    detail::stats::lookup(it != valueRef_.value_->MemberEnd());
+    return it;
+}
+
+inline void ObjectRef::on_added() const {
+    if (index_) {
+        index_->add(*valueRef_.value_);
+    }
+}
+
+inline void ObjectRef::on_erased() const {
+    if (index_) {
+        index_->invalidate();
+    }
 }
 
 inline ValueRef ObjectRef::operator[](const std::string& name) const {
-    rapidjson::Value key(name.data(), name.length());
-    auto it = valueRef_.value_.FindMember(key);
-    if (it == valueRef_.value_.MemberEnd()){
-        valueRef_.value_.AddMember(rapidjson::Value(name.data(), name.length(), valueRef_.alloc_), rapidjson::Value(), valueRef_.alloc_);
-        it = valueRef_.value_.MemberEnd()-1;
+    auto it = find_member(string_view(name));
+    if (it == valueRef_.value_->MemberEnd()){
+        valueRef_.value_->AddMember(rapidjson::Value(name.data(), name.length(), *valueRef_.alloc_), rapidjson::Value(), *valueRef_.alloc_);
+        on_added();
+        it = valueRef_.value_->MemberEnd()-1;
     }
-    return ValueRef(it->value, valueRef_.alloc_);
+    return ValueRef(it->value, *valueRef_.alloc_);
 }
 
 inline ValueRef ObjectRef::operator[](const char* name) const {
-    rapidjson::Value key(rapidjson::StringRef(name));
-    auto it = valueRef_.value_.FindMember(key);
-    if (it == valueRef_.value_.MemberEnd()) {
-        valueRef_.value_.AddMember(rapidjson::Value(rapidjson::StringRef(name), valueRef_.alloc_), rapidjson::Value(), valueRef_.alloc_);
-        it = valueRef_.value_.MemberEnd()-1;
+    auto it = find_member(string_view(name));
+    if (it == valueRef_.value_->MemberEnd()) {
+        valueRef_.value_->AddMember(rapidjson::Value(rapidjson::StringRef(name), *valueRef_.alloc_), rapidjson::Value(), *valueRef_.alloc_);
+        on_added();
+        it = valueRef_.value_->MemberEnd()-1;
     }
-    return ValueRef(it->value, valueRef_.alloc_);
+    return ValueRef(it->value, *valueRef_.alloc_);
 }
 
 inline ValueRef ObjectRef::operator[](const string_view& name) const {
-    rapidjson::Value key(rapidjson::StringRef(name.data(), name.length()));
-    auto it = valueRef_.value_.FindMember(key);
-    if (it == valueRef_.value_.MemberEnd()) {
-        valueRef_.value_.AddMember(rapidjson::Value(rapidjson::StringRef(name.data(), name.length())), rapidjson::Value(), valueRef_.alloc_);
-        it = valueRef_.value_.MemberEnd()-1;
+    auto it = find_member(name);
+    if (it == valueRef_.value_->MemberEnd()) {
+        valueRef_.value_->AddMember(rapidjson::Value(rapidjson::StringRef(name.data(), name.length())), rapidjson::Value(), *valueRef_.alloc_);
+        on_added();
+        it = valueRef_.value_->MemberEnd()-1;
+    }
+    return ValueRef(it->value, *valueRef_.alloc_);
+}
+
+inline ValueRef ObjectRef::operator[](const Key& key) const {
+    auto it = find_member(key);
+    if (it == valueRef_.value_->MemberEnd()) {
+        valueRef_.value_->AddMember(rapidjson::Value(key.data(), key.size(), *valueRef_.alloc_), rapidjson::Value(), *valueRef_.alloc_);
+        on_added();
+        it = valueRef_.value_->MemberEnd()-1;
     }
-    return ValueRef(it->value, valueRef_.alloc_);
+    return ValueRef(it->value, *valueRef_.alloc_);
 }
 
-inline optional<ValueRef> ObjectRef::find(const std::string& name) const {
+inline optional<ValueRef> ObjectRef::find(const string_view& name) const {
     optional<ValueRef> ret;
-    rapidjson::Value key(name.data(), name.length());
-    auto it = valueRef_.value_.FindMember(key);
-    if ( it != valueRef_.value_.MemberEnd() ) {
-        ret = ValueRef(it->value, valueRef_.alloc_);
+    auto it = find_member(name);
+    if ( it != valueRef_.value_->MemberEnd() ) {
+        ret = ValueRef(it->value, *valueRef_.alloc_);
     }
     return ret;
 }
 
-inline int ObjectRef::count(const std::string& name) const {
-    rapidjson::Value key(name.data(), name.length());
-    auto it = valueRef_.value_.FindMember(key);
-    return (it != valueRef_.value_.MemberEnd());
+inline optional<ValueRef> ObjectRef::find(const Key& key) const {
+    optional<ValueRef> ret;
+    auto it = find_member(key);
+    if ( it != valueRef_.value_->MemberEnd() ) {
+        ret = ValueRef(it->value, *valueRef_.alloc_);
+    }
+    return ret;
+}
+
+inline int ObjectRef::count(const string_view& name) const {
+    return (find_member(name) != valueRef_.value_->MemberEnd());
+}
+
+inline int ObjectRef::count(const Key& key) const {
+    return (find_member(key) != valueRef_.value_->MemberEnd());
+}
+
+inline bool ObjectRef::has(const Key& key) const {
+    return (find_member(key) != valueRef_.value_->MemberEnd());
 }
 
 inline size_t ObjectRef::size() const {
-    return valueRef_.value_.MemberCount();
+    return valueRef_.value_->MemberCount();
 }
 
 inline bool ObjectRef::empty() const {
-    return valueRef_.value_.ObjectEmpty();
+    return valueRef_.value_->ObjectEmpty();
 }
 
-inline bool ObjectRef::has(const std::string& name) const {
-    return valueRef_.value_.HasMember(name.c_str());
+inline bool ObjectRef::has(const string_view& name) const {
+    return (find_member(name) != valueRef_.value_->MemberEnd());
 }
 
 inline void ObjectRef::clear() {
-    return valueRef_.value_.RemoveAllMembers();
+    valueRef_.value_->RemoveAllMembers();
+    on_erased();
 }
 
 inline MemberIterator ObjectRef::begin() const {
-    return MemberIterator(valueRef_.value_.MemberBegin(), valueRef_.alloc_);
+    return MemberIterator(valueRef_.value_->MemberBegin(), *valueRef_.alloc_);
 }
 
 inline MemberIterator ObjectRef::end() const {
-    return MemberIterator(valueRef_.value_.MemberEnd(), valueRef_.alloc_);
+    return MemberIterator(valueRef_.value_->MemberEnd(), *valueRef_.alloc_);
 }
 
 template<typename T>
 inline void ObjectRef::insert(const char* name, T&& value) {          // key copy
     rapidjson::Value temp;
-    ValueRef dummy(temp, valueRef_.alloc_);
+    ValueRef dummy(temp, *valueRef_.alloc_);
     dummy = std::forward<T>(value);
-    valueRef_.value_.AddMember(rapidjson::Value(name, strlen(name), valueRef_.alloc_), temp.Move(), valueRef_.alloc_);
+    valueRef_.value_->AddMember(rapidjson::Value(name, strlen(name), *valueRef_.alloc_), temp.Move(), *valueRef_.alloc_);
+    on_added();
 }
 
 template<typename T>
 inline void ObjectRef::insert(const std::string& name, T&& value) {
     rapidjson::Value temp;
-    ValueRef dummy(temp, valueRef_.alloc_);
+    ValueRef dummy(temp, *valueRef_.alloc_);
     dummy = std::forward<T>(value);
-    valueRef_.value_.AddMember(rapidjson::Value(name.data(), name.length(), valueRef_.alloc_), temp.Move(), valueRef_.alloc_);
+    valueRef_.value_->AddMember(rapidjson::Value(name.data(), name.length(), *valueRef_.alloc_), temp.Move(), *valueRef_.alloc_);
+    on_added();
 }
 
 template<typename T>
 inline void ObjectRef::insert(const string_view& name, T&& value) {
     rapidjson::Value temp;
-    ValueRef dummy(temp, valueRef_.alloc_);
+    ValueRef dummy(temp, *valueRef_.alloc_);
     dummy = std::forward<T>(value);
-    valueRef_.value_.AddMember(rapidjson::Value(name.data(), name.length()), temp.Move(), valueRef_.alloc_);
+    valueRef_.value_->AddMember(rapidjson::Value(name.data(), name.length()), temp.Move(), *valueRef_.alloc_);
+    on_added();
 }
 
 inline ValueRef ObjectRef::insert(const char* name) {
-    valueRef_.value_.AddMember(rapidjson::Value(name, strlen(name), valueRef_.alloc_), rapidjson::Value(), valueRef_.alloc_);
-    auto it = (valueRef_.value_.MemberEnd() - 1);
-    return ValueRef(it->value, valueRef_.alloc_);
+    valueRef_.value_->AddMember(rapidjson::Value(name, strlen(name), *valueRef_.alloc_), rapidjson::Value(), *valueRef_.alloc_);
+    on_added();
+    auto it = (valueRef_.value_->MemberEnd() - 1);
+    return ValueRef(it->value, *valueRef_.alloc_);
 }
 
 inline ValueRef ObjectRef::insert(const std::string& name) {
-    valueRef_.value_.AddMember(rapidjson::Value(name.data(), name.length(), valueRef_.alloc_), rapidjson::Value(), valueRef_.alloc_);
-    auto it = (valueRef_.value_.MemberEnd() - 1);
-    return ValueRef(it->value, valueRef_.alloc_);
+    valueRef_.value_->AddMember(rapidjson::Value(name.data(), name.length(), *valueRef_.alloc_), rapidjson::Value(), *valueRef_.alloc_);
+    on_added();
+    auto it = (valueRef_.value_->MemberEnd() - 1);
+    return ValueRef(it->value, *valueRef_.alloc_);
 }
 
 inline ValueRef ObjectRef::insert(const string_view& name) {
-    valueRef_.value_.AddMember(rapidjson::Value(name.data(), name.length()), rapidjson::Value(), valueRef_.alloc_);
-    auto it = (valueRef_.value_.MemberEnd() - 1);
-    return ValueRef(it->value, valueRef_.alloc_);
+    valueRef_.value_->AddMember(rapidjson::Value(name.data(), name.length()), rapidjson::Value(), *valueRef_.alloc_);
+    on_added();
+    auto it = (valueRef_.value_->MemberEnd() - 1);
+    return ValueRef(it->value, *valueRef_.alloc_);
 }
 
-inline MemberIterator ObjectRef::erase(const std::string& name)  {
-    auto it = valueRef_.value_.FindMember(rapidjson::Value(name.data(), name.length()));
-    if (it != valueRef_.value_.MemberEnd()) {
-        return MemberIterator(valueRef_.value_.EraseMember(it), valueRef_.alloc_);
-    } else {
-        return MemberIterator(it, valueRef_.alloc_);
+inline MemberIterator ObjectRef::erase(const string_view& name)  {
+    auto it = find_member(name);
+    if (it != valueRef_.value_->MemberEnd()) {
+        it = valueRef_.value_->EraseMember(it);
+        on_erased();
     }
+    return MemberIterator(it, *valueRef_.alloc_);
 }
 
 inline MemberIterator ObjectRef::erase(const MemberIterator& pos) {
-    return MemberIterator(valueRef_.value_.EraseMember(pos.ptr_), valueRef_.alloc_);
+    on_erased();
+    return MemberIterator(valueRef_.value_->EraseMember(pos.ptr_), *valueRef_.alloc_);
 }
 
 inline MemberIterator ObjectRef::erase(const MemberIterator& first, const MemberIterator& last) {
-    return MemberIterator(valueRef_.value_.EraseMember(first.ptr_, last.ptr_), valueRef_.alloc_);
+    on_erased();
+    return MemberIterator(valueRef_.value_->EraseMember(first.ptr_, last.ptr_), *valueRef_.alloc_);
+}
+
+inline std::string ObjectRef::to_string(bool pretty) const {
+    return valueRef_.to_string(pretty);
+}
+
+inline bool ObjectRef::write_to(std::string& buffer, bool pretty) const {
+    return valueRef_.write_to(buffer, pretty);
+}
+
+inline bool ObjectRef::append_to(std::string& buffer, bool pretty) const {
+    return valueRef_.append_to(buffer, pretty);
+}
+
+inline bool ObjectRef::write_to(rapidjson::StringBuffer& buffer, bool pretty) const {
+    return valueRef_.write_to(buffer, pretty);
+}
+
+inline bool ObjectRef::write_to(std::ostream& os, bool pretty) const {
+    return valueRef_.write_to(os, pretty);
+}
+
+inline bool ObjectRef::write_to_file(const std::string& path, bool pretty) const {
+    return valueRef_.write_to_file(path, pretty);
+}
+
+inline bool ObjectRef::write_to_file(const std::string& path, const SaveOptions& options) const {
+    return valueRef_.write_to_file(path, options);
 }
 
 inline ValueRef ObjectRef::get_value_ref() const {
@@ -881,7 +1154,7 @@ inline ValueRef ObjectRef::get_value_ref() const {
 /////////////////////////////////////////////////////////////////////////////////////////////
 
 template<typename T>
-inline T ObjectRef::get_value(const std::string& name, const T& defval) const {
+inline T ObjectRef::get_value(const string_view& name, const T& defval) const {
     optional<T> value = get_value<T>(name);
     if ( not value ) {
         value = defval;
@@ -890,33 +1163,88 @@ inline T ObjectRef::get_value(const std::string& name, const T& defval) const {
 }
 
 template<typename T, detail::enable_if_str_t<T>*>
-inline optional<std::string> ObjectRef::get_value(const std::string& name) const {
+inline optional<std::string> ObjectRef::get_value(const string_view& name) const {
+    optional<std::string> ret;
+    auto it = find_member(name);
+    if ( it != valueRef_.value_->MemberEnd() and it->value.IsString()) {
+        ret = std::string(it->value.GetString(), it->value.GetStringLength());
+    }
+    return ret;
+}
+
+template<typename T, detail::enable_if_cptr_t<T>*>
+inline optional<const char*> ObjectRef::get_value(const string_view& name) const {
+    optional<const char*> ret;
+    auto it = find_member(name);
+    if ( it != valueRef_.value_->MemberEnd() and it->value.IsString()) {
+        ret = it->value.GetString();
+    }
+    return ret;
+}
+
+template<typename T, detail::enable_if_sv_t<T>*>
+inline optional<string_view> ObjectRef::get_value(const string_view& name) const {
+    optional<string_view> ret;
+    auto it = find_member(name);
+    if ( it != valueRef_.value_->MemberEnd() and it->value.IsString()) {
+        ret = string_view(it->value.GetString(), it->value.GetStringLength());
+    }
+    return ret;
+}
+
+template<typename T, detail::enable_if_num_t<T>*>
+inline optional<T> ObjectRef::get_value(const string_view& name) const {
+    auto it = find_member(name);
+    if ( it != valueRef_.value_->MemberEnd() ) {
+        return ValueRef(it->value, *valueRef_.alloc_).get<T>();
+    }
+    return optional<T>();
+}
+
+template<typename T>
+inline T ObjectRef::get_value(const Key& key, const T& defval) const {
+    optional<T> value = get_value<T>(key);
+    if ( not value ) {
+        value = defval;
+    }
+    return *value;
+}
+
+template<typename T, detail::enable_if_str_t<T>*>
+inline optional<std::string> ObjectRef::get_value(const Key& key) const {
     optional<std::string> ret;
-    rapidjson::Value key(name.data(), name.length());
-    auto it = valueRef_.value_.FindMember(key);
-    if ( it != valueRef_.value_.MemberEnd() and it->value.IsString()) {
+    auto it = find_member(key);
+    if ( it != valueRef_.value_->MemberEnd() and it->value.IsString()) {
         ret = std::string(it->value.GetString(), it->value.GetStringLength());
     }
     return ret;
 }
 
 template<typename T, detail::enable_if_cptr_t<T>*>
-inline optional<const char*> ObjectRef::get_value(const std::string& name) const {
+inline optional<const char*> ObjectRef::get_value(const Key& key) const {
     optional<const char*> ret;
-    rapidjson::Value key(name.data(), name.length());
-    auto it = valueRef_.value_.FindMember(key);
-    if ( it != valueRef_.value_.MemberEnd() and it->value.IsString()) {
+    auto it = find_member(key);
+    if ( it != valueRef_.value_->MemberEnd() and it->value.IsString()) {
         ret = it->value.GetString();
     }
     return ret;
 }
 
+template<typename T, detail::enable_if_sv_t<T>*>
+inline optional<string_view> ObjectRef::get_value(const Key& key) const {
+    optional<string_view> ret;
+    auto it = find_member(key);
+    if ( it != valueRef_.value_->MemberEnd() and it->value.IsString()) {
+        ret = string_view(it->value.GetString(), it->value.GetStringLength());
+    }
+    return ret;
+}
+
 template<typename T, detail::enable_if_num_t<T>*>
-inline optional<T> ObjectRef::get_value(const std::string& name) const {
-    rapidjson::Value key(name.data(), name.length());
-    auto it = valueRef_.value_.FindMember(key);
-    if ( it != valueRef_.value_.MemberEnd() ) {
-        return ValueRef(it->value, valueRef_.alloc_).get<T>();
+inline optional<T> ObjectRef::get_value(const Key& key) const {
+    auto it = find_member(key);
+    if ( it != valueRef_.value_->MemberEnd() ) {
+        return ValueRef(it->value, *valueRef_.alloc_).get<T>();
     }
     return optional<T>();
 }
@@ -926,23 +1254,23 @@ inline optional<T> ObjectRef::get_value(const std::string& name) const {
 /// ValueRef::find_xxx tempalte impl
 /////////////////////////////////////////////////////////////////////////////////////////////
 template<template <typename...> class Container, typename...Args, detail::enable_if_sequence_t<std::string, Container, Args...>*>
-inline MemberIterator ObjectRef::find_any(Container<std::string> names) const
+inline MemberIterator ObjectRef::find_any(const Container<std::string>& names) const
 {
     for ( const auto& name : names ) {
-        auto it = valueRef_.value_.FindMember(rapidjson::Value(name.data(), name.length()));
-        if (it != valueRef_.value_.MemberEnd()) {
-            return MemberIterator(it, valueRef_.alloc_);
+        auto it = find_member(name);
+        if (it != valueRef_.value_->MemberEnd()) {
+            return MemberIterator(it, *valueRef_.alloc_);
         }
     }
-    return MemberIterator(valueRef_.value_.MemberEnd(), valueRef_.alloc_);
+    return MemberIterator(valueRef_.value_->MemberEnd(), *valueRef_.alloc_);
 }
 
 template<template <typename...> class Container, typename...Args, detail::enable_if_sequence_t<std::string, Container, Args...>*>
-inline bool ObjectRef::find_all(Container<std::string> names) const
+inline bool ObjectRef::find_all(const Container<std::string>& names) const
 {
     for ( const auto& name : names ) {
-        auto it = valueRef_.value_.FindMember(rapidjson::Value(name.data(), name.length()));
-        if (it == valueRef_.value_.MemberEnd()) {
+        auto it = find_member(name);
+        if (it == valueRef_.value_->MemberEnd()) {
             return false;
         }
     }
@@ -0,0 +1,132 @@
+#ifndef WRAPIDJSON_WRITER_H_
+#define WRAPIDJSON_WRITER_H_
+
+#include <string>
+#include <ostream>
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/prettywriter.h>
+
+#include "stream.h"
+#include "stats.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// rapidjson output stream appending to std::string ( no intermediate StringBuffer )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class StringOStream {
+public:
+    using Ch = char;
+
+    explicit StringOStream(std::string& buffer) : buffer_(buffer) {}
+
+    void Put(Ch c) { buffer_.push_back(c); }
+    void Flush() {}
+
+    /// geometric growth, std::string::reserve may allocate exact size
+    void Reserve(size_t count) {
+        size_t need = buffer_.size() + count;
+        if (need > buffer_.capacity()) {
+            buffer_.reserve(need > buffer_.capacity() * 2 ? need : buffer_.capacity() * 2);
+        }
+    }
+
+private:
+    std::string& buffer_;
+};
+
+} // namespace detail
+} // namespace wrapidjson
+
+namespace rapidjson {
+template<>
+inline void PutReserve(wrapidjson::detail::StringOStream& stream, size_t count) {
+    stream.Reserve(count);
+}
+} // namespace rapidjson
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// serialize rapidjson::Value in place ( Accept on referenced value, nothing is copied )
+/////////////////////////////////////////////////////////////////////////////////////////////
+template<typename OutputStream>
+inline bool accept_value(const rapidjson::Value& value, OutputStream& os, bool pretty) {
+    if (pretty) {
+        rapidjson::PrettyWriter<OutputStream> writer(os);
+        return value.Accept(writer);
+    } else {
+        rapidjson::Writer<OutputStream> writer(os);
+        return value.Accept(writer);
+    }
+}
+
+#if WRAPIDJSON_ENABLE_STATS
+/// counts bytes out for stats
+template<typename OutputStream>
+class CountingOStream {
+public:
+    using Ch = typename OutputStream::Ch;
+
+    explicit CountingOStream(OutputStream& os) : os_(os), count_(0) {}
+
+    void Put(Ch c) { os_.Put(c); ++count_; }
+    void Flush() { os_.Flush(); }
+    size_t count() const { return count_; }
+
+private:
+    OutputStream&   os_;
+    size_t          count_;
+};
+
+template<typename OutputStream>
+inline bool write_stream(const rapidjson::Value& value, OutputStream& os, bool pretty) {
+    stats::SerializeScope stats;
+    CountingOStream<OutputStream> counting(os);
+    bool ret = accept_value(value, counting, pretty);
+    return stats.done(counting.count(), ret);
+}
+#else
+template<typename OutputStream>
+inline bool write_stream(const rapidjson::Value& value, OutputStream& os, bool pretty) {
+    return accept_value(value, os, pretty);
+}
+#endif
+
+/// append to StringBuffer ( Clear() it to reuse )
+inline bool write_value(const rapidjson::Value& value, rapidjson::StringBuffer& buffer, bool pretty) {
+    return write_stream(value, buffer, pretty);
+}
+
+/// append to std::string ( reserved capacity is reused, rolled back on failure )
+inline bool append_value(const rapidjson::Value& value, std::string& buffer, bool pretty) {
+    size_t size = buffer.size();
+    StringOStream os(buffer);
+    bool ret = write_stream(value, os, pretty);
+    if (not ret) {
+        buffer.resize(size);
+    }
+    return ret;
+}
+
+/// replace std::string contents ( written in place, capacity is reused, empty on failure )
+inline bool write_value(const rapidjson::Value& value, std::string& buffer, bool pretty) {
+    buffer.clear();
+    return append_value(value, buffer, pretty);
+}
+
+inline bool write_value(const rapidjson::Value& value, std::ostream& os, bool pretty,
+        size_t buffer_size = OStream::DEFAULT_BUFFER_SIZE) {
+    OStream os_wrapper(os, buffer_size);
+    return write_stream(value, os_wrapper, pretty);
+}
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_WRITER_H_